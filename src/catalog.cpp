@@ -27,6 +27,7 @@
 
 #include "catalog_po.h"
 #include "catalog_xliff.h"
+#include "compression.h"
 
 #include "configuration.h"
 #include "errors.h"
@@ -592,7 +593,7 @@ wxString Catalog::GetTypesFileMask(std::initializer_list<Type> types)
 
 wxString Catalog::GetAllTypesFileMask()
 {
-    return MaskForType("*.po;*.pot;*.xlf;*.xliff", _("All Translation Files"), /*showExt=*/false) +
+    return MaskForType("*.po;*.pot;*.xlf;*.xliff;*.po.gz;*.xlf.gz;*.xliff.gz", _("All Translation Files"), /*showExt=*/false) +
            "|" +
            GetTypesFileMask({Type::PO, Type::POT, Type::XLIFF});
 }
@@ -805,10 +806,79 @@ bool Catalog::HasPluralItems() const
     return false;
 }
 
+bool Catalog::ReloadDiff::HasSameItems() const
+{
+    if (!addedItems.empty() || !removedItems.empty())
+        return false;
+    for (size_t i = 0; i < oldIndexes.size(); i++)
+    {
+        if (oldIndexes[i] != (int)i)
+            return false;
+    }
+    return true;
+}
+
+bool Catalog::CompareWithReloaded(const Catalog& reloaded, ReloadDiff& diff) const
+{
+    diff = ReloadDiff();
+
+    if (m_fileType != reloaded.m_fileType)
+        return false;
+    if (GetLanguage() != reloaded.GetLanguage() || GetSourceLanguage() != reloaded.GetSourceLanguage())
+        return false;
+    if (m_header.GetHeader("Plural-Forms") != reloaded.m_header.GetHeader("Plural-Forms"))
+        return false;
+
+    auto keyOf = [](const CatalogItem& item) -> wxString
+    {
+        return item.HasContext() ? item.GetContext() + wxS('\x04') + item.GetString() : item.GetString();
+    };
+
+    // Items are identified by (msgctxt, msgid). That's unique in valid files,
+    // but duplicates are matched in order if present.
+    std::map<wxString, std::vector<int>> oldByKey;
+    for (int i = (int)m_items.size() - 1; i >= 0; i--)
+        oldByKey[keyOf(*m_items[i])].push_back(i);
+
+    std::vector<bool> matched(m_items.size(), false);
+    diff.oldIndexes.resize(reloaded.m_items.size(), -1);
+
+    for (size_t i = 0; i < reloaded.m_items.size(); i++)
+    {
+        auto& b = *reloaded.m_items[i];
+        auto found = oldByKey.find(keyOf(b));
+        if (found == oldByKey.end() || found->second.empty())
+        {
+            diff.addedItems.push_back((int)i);
+            continue;
+        }
+
+        const int oldIndex = found->second.back();
+        found->second.pop_back();
+        diff.oldIndexes[i] = oldIndex;
+        matched[oldIndex] = true;
+
+        if (!m_items[oldIndex]->HasSameContentAs(b))
+            diff.changedItems.push_back((int)i);
+    }
+
+    for (size_t i = 0; i < m_items.size(); i++)
+    {
+        if (!matched[i])
+            diff.removedItems.push_back((int)i);
+    }
+
+    return true;
+}
+
 void Catalog::SetLanguage(Language lang)
 {
     m_header.Lang = lang;
     m_header.SetHeaderNotEmpty("Plural-Forms", lang.DefaultPluralFormsExpr().str());
+
+    // translations' word counts depend on the language
+    for (auto& i: m_items)
+        i->InvalidateCachedWordCounts();
 }
 
 void Catalog::GetStatistics(int *all, int *fuzzy, int *badtokens,
@@ -935,6 +1005,7 @@ void CatalogItem::SetTranslation(const wxString &t, unsigned idx)
         }
     }
 
+    InvalidateCachedWordCounts();
     UpdateInternalRepresentation();
 }
 
@@ -954,6 +1025,7 @@ void CatalogItem::SetTranslations(const wxArrayString &t)
         }
     }
 
+    InvalidateCachedWordCounts();
     UpdateInternalRepresentation();
 }
 
@@ -984,6 +1056,7 @@ void CatalogItem::SetTranslationFromSource()
         }
     }
 
+    InvalidateCachedWordCounts();
     UpdateInternalRepresentation();
 }
 
@@ -999,6 +1072,7 @@ void CatalogItem::ClearTranslation()
         t.clear();
     }
 
+    InvalidateCachedWordCounts();
     UpdateInternalRepresentation();
 }
 
@@ -1011,6 +1085,25 @@ unsigned CatalogItem::GetPluralFormsCount() const
     return trans - 1;
 }
 
+bool CatalogItem::HasSameContentAs(const CatalogItem& other) const
+{
+    return m_string == other.m_string &&
+           m_hasPlural == other.m_hasPlural &&
+           m_plural == other.m_plural &&
+           m_hasContext == other.m_hasContext &&
+           m_context == other.m_context &&
+           m_translations == other.m_translations &&
+           m_isFuzzy == other.m_isFuzzy &&
+           m_isTranslated == other.m_isTranslated &&
+           m_isPreTranslated == other.m_isPreTranslated &&
+           m_moreFlags == other.m_moreFlags &&
+           m_comment == other.m_comment &&
+           m_extractedComments == other.m_extractedComments &&
+           m_oldMsgid == other.m_oldMsgid &&
+           m_bookmark == other.m_bookmark &&
+           GetReferences() == other.GetReferences();
+}
+
 wxString CatalogItem::GetOldMsgid() const
 {
     wxString s;
@@ -1052,8 +1145,9 @@ CatalogPtr Catalog::Create(Type type)
 
 CatalogPtr Catalog::Create(const wxString& filename, int flags)
 {
+    // compressed files are handled transparently, their type is given by the inner extension:
     wxString ext;
-    wxFileName::SplitPath(filename, nullptr, nullptr, nullptr, &ext);
+    wxFileName::SplitPath(StripGzipExtension(filename), nullptr, nullptr, nullptr, &ext);
     ext.MakeLower();
 
     CatalogPtr cat;
@@ -85,7 +85,8 @@ class CatalogItem
                   m_isModified(false),
                   m_isPreTranslated(false),
                   m_lineNum(0),
-                  m_bookmark(NO_BOOKMARK) {}
+                  m_bookmark(NO_BOOKMARK),
+                  m_hasWordCounts(false) {}
 
         CatalogItem(const CatalogItem&) = delete;
 
@@ -173,6 +174,10 @@ class CatalogItem
         /// Returns true if the item has a bookmark
         bool HasBookmark() const {return (GetBookmark() != NO_BOOKMARK);}
 
+        /// Returns true if the item has the same texts, flags, comments and
+        /// references as @a other (e.g. the same entry loaded again)
+        bool HasSameContentAs(const CatalogItem& other) const;
+
 
         // -------------------------------------------------------------------
         // Setters for user-editable values:
@@ -235,6 +240,18 @@ class CatalogItem
         void SetIssue(const Issue& issue) { m_issue = std::make_shared<Issue>(issue); }
         void SetIssue(Issue::Severity severity, const wxString& message) { m_issue = std::make_shared<Issue>(severity, message); }
 
+        /// Word and character counts of the item's texts, see GetWordStatistics()
+        struct WordCounts
+        {
+            int sourceWords, sourceChars;
+            int translationWords, translationChars;
+        };
+
+        bool HasCachedWordCounts() const { return m_hasWordCounts; }
+        const WordCounts& GetCachedWordCounts() const { return m_wordCounts; }
+        void SetCachedWordCounts(const WordCounts& counts) { m_wordCounts = counts; m_hasWordCounts = true; }
+        void InvalidateCachedWordCounts() { m_hasWordCounts = false; }
+
     protected:
         // API for subclasses:
         virtual void UpdateInternalRepresentation() = 0;
@@ -250,12 +267,14 @@ class CatalogItem
         {
             m_string = s;
             ClearIssue();
+            InvalidateCachedWordCounts();
         }
 
         void SetPluralString(const wxString& p)
         {
             m_plural = p;
             m_hasPlural = true;
+            InvalidateCachedWordCounts();
         }
 
         void SetContext(const wxString& context)
@@ -300,6 +319,9 @@ class CatalogItem
         Bookmark m_bookmark;
 
         std::shared_ptr<Issue> m_issue;
+
+        bool m_hasWordCounts;
+        WordCounts m_wordCounts;
 };
 
 
@@ -537,6 +559,39 @@ class Catalog
         /// Does this catalog have any items with plural forms?
         bool HasPluralItems() const;
 
+        /// Differences between two versions of a catalog, see CompareWithReloaded()
+        struct ReloadDiff
+        {
+            /// For each item of the reloaded catalog, index of the same item
+            /// in the original one, or -1 if the item is new
+            std::vector<int> oldIndexes;
+            /// Indexes (in the reloaded catalog) of items present in both
+            /// versions, but with different content
+            std::vector<int> changedItems;
+            /// Indexes (in the reloaded catalog) of new items
+            std::vector<int> addedItems;
+            /// Indexes (in the original catalog) of items that were removed
+            std::vector<int> removedItems;
+
+            /// Are the items the same, in the same order, with only (some of)
+            /// their content changed?
+            bool HasSameItems() const;
+        };
+
+        /**
+            Compares the catalog with another version of the same file, e.g.
+            one loaded again after it was modified externally.
+
+            Items are matched by their context and source text, so that added,
+            removed or moved items are detected, as is common after msgmerge
+            or version control updates.
+
+            Returns false if the two versions can't be compared, e.g. because
+            the languages or plural forms differ. Otherwise returns true and
+            fills @a diff.
+         */
+        bool CompareWithReloaded(const Catalog& reloaded, ReloadDiff& diff) const;
+
         /** Returns status of catalog object: true if ok, false if damaged
             (i.e. constructor or Load failed).
          */
@@ -25,6 +25,8 @@
 
 #include "catalog_po.h"
 
+#include "catalog_snapshot.h"
+#include "compression.h"
 #include "configuration.h"
 #include "errors.h"
 #include "extractors/extractor.h"
@@ -119,7 +121,7 @@ bool ReadParam(const wxString& input, const wxString& pattern, wxString& output)
 bool VerifyFileCharset(const wxTextFile& f, const wxString& filename,
                        const wxString& charset)
 {
-    wxTextFile f2;
+    GzipTextFile f2;
 
     if (!f2.Open(filename, wxConvISO8859_1))
         return false;
@@ -605,6 +607,10 @@ class POLoadParser : public POCatalogParser
         // true if the file is valid, i.e. has at least some data
         bool FileIsValid;
 
+        // header entry's text as it appears in the file, if there was any
+        bool HasHeader() const { return m_seenHeaderAlready; }
+        const wxString& GetRawHeader() const { return m_rawHeader; }
+
         Language GetMsgidLanguage()
         {
             auto lang = GetSpecifiedMsgidLanguage();
@@ -660,6 +666,7 @@ class POLoadParser : public POCatalogParser
     private:
         int m_nextId;
         bool m_seenHeaderAlready;
+        wxString m_rawHeader;
 
         // collected text of msgids, with newlines, for language detection
         bool m_collectMsgidText;
@@ -691,6 +698,7 @@ bool POLoadParser::OnEntry(const wxString& msgid,
             // gettext header:
             m_catalog.m_header.FromString(mtranslations[0]);
             m_catalog.m_header.Comment = comment;
+            m_rawHeader = mtranslations[0];
             m_collectMsgidText = !GetSpecifiedMsgidLanguage().IsValid();
             m_seenHeaderAlready = true;
         }
@@ -762,6 +770,78 @@ bool POLoadParser::OnDeletedEntry(const wxArrayString& deletedLines,
 }
 
 
+namespace
+{
+
+class POStreamParser : public POCatalogParser
+{
+    public:
+        POStreamParser(wxTextFile *f, const std::function<bool(const POStreamReader::Entry&)>& callback)
+            : POCatalogParser(f), m_callback(callback) {}
+
+    protected:
+        bool OnEntry(const wxString& msgid,
+                     const wxString& msgid_plural,
+                     bool has_plural,
+                     bool has_context,
+                     const wxString& context,
+                     const wxArrayString& mtranslations,
+                     const wxString& flags,
+                     const wxArrayString& /*references*/,
+                     const wxString& /*comment*/,
+                     const wxArrayString& /*extractedComments*/,
+                     const wxArrayString& /*msgid_old*/,
+                     unsigned lineNumber) override
+        {
+            if (msgid.empty() && !has_context)
+                return true; // gettext header
+
+            POStreamReader::Entry e;
+            e.context = context;
+            e.hasContext = has_context;
+            e.source = msgid;
+            e.sourcePlural = msgid_plural;
+            e.hasPlural = has_plural;
+            e.translations = mtranslations;
+            e.isFuzzy = flags.find(wxS(", fuzzy")) != wxString::npos;
+            e.lineNumber = lineNumber;
+            return m_callback(e);
+        }
+
+    private:
+        const std::function<bool(const POStreamReader::Entry&)>& m_callback;
+};
+
+} // anonymous namespace
+
+
+bool POStreamReader::ForEachEntry(const std::function<bool(const Entry&)>& callback)
+{
+    GzipTextFile f;
+    if (!f.Open(m_filename, wxConvISO8859_1))
+        return false;
+
+    wxString charset;
+    {
+        wxLogNull null;
+        POCharsetInfoFinder charsetFinder(&f);
+        charsetFinder.Parse();
+        charset = charsetFinder.GetCharset();
+    }
+
+    f.Close();
+    wxCSConv encConv(charset);
+    if (!f.Open(m_filename, encConv))
+        return false;
+
+    POStreamParser parser(&f, callback);
+    // a callback stopping the iteration early isn't an error, so the
+    // result of Parse() can't be used to tell failures apart:
+    parser.Parse();
+    return true;
+}
+
+
 // ----------------------------------------------------------------------
 // POCatalogItem class
 // ----------------------------------------------------------------------
@@ -857,20 +937,62 @@ static inline wxString GetCurrentTimeString()
 
 bool POCatalog::Load(const wxString& po_file, int flags)
 {
-    wxTextFile f;
-
     Clear();
     m_isOk = false;
     m_fileName = po_file;
     m_header.BasePath = wxEmptyString;
+    m_snapshot.reset();
 
     wxString ext;
-    wxFileName::SplitPath(po_file, nullptr, nullptr, &ext);
+    wxFileName::SplitPath(StripGzipExtension(po_file), nullptr, nullptr, &ext);
     if (ext.CmpNoCase("pot") == 0)
         m_fileType = Type::POT;
     else
         m_fileType = Type::PO;
 
+    // Parsing large files is slow, so reuse the result of the last parsing
+    // if the file didn't change since then:
+    if (flags == 0 && POCatalogSnapshot::IsUsefulFor(po_file))
+        m_snapshot = std::make_shared<POCatalogSnapshot>(po_file);
+
+    if (!m_snapshot || !m_snapshot->Restore(*this))
+    {
+        if (!Parse(po_file, flags, m_snapshot.get()))
+            return false;
+    }
+
+    // now that the catalog is loaded, update its items with the bookmarks
+    for (unsigned i = BOOKMARK_0; i < BOOKMARK_LAST; i++)
+    {
+        if (m_header.Bookmarks[i] == -1)
+            continue;
+
+        if (m_header.Bookmarks[i] < (int)m_items.size())
+        {
+            m_items[m_header.Bookmarks[i]]->SetBookmark(
+                    static_cast<Bookmark>(i));
+        }
+        else // invalid bookmark
+        {
+            m_header.Bookmarks[i] = -1;
+        }
+    }
+
+    m_isOk = true;
+
+    FixupCommonIssues();
+
+    if ( flags & CreationFlag_IgnoreHeader )
+        CreateNewHeader();
+
+    return true;
+}
+
+
+bool POCatalog::Parse(const wxString& po_file, int flags, POCatalogSnapshot *snapshot)
+{
+    GzipTextFile f;
+
     /* Load the .po file: */
 
     if (!f.Open(po_file, wxConvISO8859_1))
@@ -907,23 +1029,6 @@ bool POCatalog::Load(const wxString& po_file, int flags)
 
     m_sourceLanguage = parser.GetMsgidLanguage();
 
-    // now that the catalog is loaded, update its items with the bookmarks
-    for (unsigned i = BOOKMARK_0; i < BOOKMARK_LAST; i++)
-    {
-        if (m_header.Bookmarks[i] == -1)
-            continue;
-
-        if (m_header.Bookmarks[i] < (int)m_items.size())
-        {
-            m_items[m_header.Bookmarks[i]]->SetBookmark(
-                    static_cast<Bookmark>(i));
-        }
-        else // invalid bookmark
-        {
-            m_header.Bookmarks[i] = -1;
-        }
-    }
-
     m_fileCRLF = GetFileCRLFFormat(f);
     m_fileWrappingWidth = parser.GetWrappingWidth();
     wxLogTrace("poedit", "detect line wrapping: %d", m_fileWrappingWidth);
@@ -932,14 +1037,10 @@ bool POCatalog::Load(const wxString& po_file, int flags)
     if (!parser.FileIsValid)
         return false;
 
-    m_isOk = true;
-
     f.Close();
 
-    FixupCommonIssues();
-
-    if ( flags & CreationFlag_IgnoreHeader )
-        CreateNewHeader();
+    if (snapshot)
+        snapshot->Store(*this, parser.HasHeader(), parser.GetRawHeader());
 
     return true;
 }
@@ -1044,6 +1145,20 @@ void POCatalog::Clear()
 namespace
 {
 
+// Moves finished temporary file to its final location, compressing it if
+// the destination is compressed; gettext tools only work with the former
+bool ReplaceOutputFile(const wxString& temp, const wxString& dest)
+{
+    if (!IsGzipFileName(dest))
+        return TempOutputFileFor::ReplaceFile(temp, dest);
+
+    TempOutputFileFor compressed(dest);
+    if (!GzipCompressFile(temp, compressed.FileName()))
+        return false;
+    wxRemoveFile(temp);
+    return compressed.Commit();
+}
+
 inline bool CanEncodeStringToCharset(const wxString& s, wxMBConv& conv)
 {
     if (s.empty())
@@ -1173,6 +1288,9 @@ bool POCatalog::Save(const wxString& po_file, bool save_mo,
             break;
     }
 
+    // the file on disk won't match the loaded snapshot anymore:
+    m_snapshot.reset();
+
     TempOutputFileFor po_file_temp_obj(po_file);
     const wxString po_file_temp = po_file_temp_obj.FileName();
 
@@ -1252,7 +1370,7 @@ bool POCatalog::Save(const wxString& po_file, bool save_mo,
                 finalFile.Write(outputCrlf, conv);
         }
 
-        if (!TempOutputFileFor::ReplaceFile(po_file_temp2, po_file))
+        if (!ReplaceOutputFile(po_file_temp2, po_file))
             msgcat_ok = false;
     }
 
@@ -1262,7 +1380,7 @@ bool POCatalog::Save(const wxString& po_file, bool save_mo,
     }
     else
     {
-        if ( !po_file_temp_obj.Commit() )
+        if ( !ReplaceOutputFile(po_file_temp, po_file) )
         {
             wxLogError(_(L"Couldn’t save file %s."), po_file.c_str());
         }
@@ -1285,6 +1403,11 @@ bool POCatalog::Save(const wxString& po_file, bool save_mo,
     if (!wxConfig::Get()->Read("compile_mo", (long)true))
         compileMO = false;
 
+    // msgfmt can't read compressed files and there's no MO file to put
+    // alongside them anyway, compressed catalogs are used as archives
+    if (IsGzipFileName(po_file))
+        compileMO = false;
+
     if (m_fileType == Type::PO && compileMO)
     {
         const wxString mo_file = wxFileName::StripExtension(po_file) + ".mo";
@@ -1623,7 +1746,8 @@ Catalog::ValidationResults POCatalog::Validate(bool wasJustLoaded)
     if (!HasCapability(Catalog::Cap::Translations))
         return ValidationResults();  // no errors in POT files
 
-    if (wasJustLoaded)
+    // msgfmt can only validate uncompressed files directly
+    if (wasJustLoaded && !IsGzipFileName(GetFileName()))
     {
         return DoValidate(GetFileName());
     }
@@ -1645,12 +1769,21 @@ Catalog::ValidationResults POCatalog::DoValidate(const wxString& po_file)
 {
     ValidationResults res;
 
+    // msgfmt's results for the file as loaded don't change, so they are
+    // cached alongside the snapshot:
+    auto snapshot = (po_file == m_fileName) ? m_snapshot : nullptr;
+
     GettextErrors err;
-    ExecuteGettextAndParseOutput
-    (
-        wxString::Format("msgfmt -o /dev/null -c %s", QuoteCmdlineArg(CliSafeFileName(po_file))),
-        err
-    );
+    if (!snapshot || !snapshot->RestoreValidation(err))
+    {
+        ExecuteGettextAndParseOutput
+        (
+            wxString::Format("msgfmt -o /dev/null -c %s", QuoteCmdlineArg(CliSafeFileName(po_file))),
+            err
+        );
+        if (snapshot)
+            snapshot->StoreValidation(err);
+    }
 
     for (auto& i: m_items)
         i->ClearIssue();
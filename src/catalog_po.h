@@ -28,8 +28,11 @@
 
 #include "catalog.h"
 
+#include <functional>
+
 class POCatalogItem;
 class POCatalog;
+class POCatalogSnapshot;
 typedef std::shared_ptr<POCatalogItem> POCatalogItemPtr;
 typedef std::shared_ptr<POCatalog> POCatalogPtr;
 
@@ -50,6 +53,7 @@ protected:
 
     friend class POLoadParser;
     friend class POCatalog;
+    friend class POCatalogSnapshot;
 
 protected:
     wxArrayString m_references;
@@ -209,6 +213,9 @@ protected:
      */
     bool Load(const wxString& po_file, int flags = 0);
 
+    /// Parses the file; used by Load() if there's no usable snapshot.
+    bool Parse(const wxString& po_file, int flags, POCatalogSnapshot *snapshot);
+
     void Clear();
 
     /// Adds entry to the catalog (the catalog will take ownership of
@@ -245,7 +252,51 @@ protected:
     wxTextFileType m_fileCRLF;
     int m_fileWrappingWidth;
 
+    // snapshot of the file as loaded, if it's large enough to use one
+    std::shared_ptr<POCatalogSnapshot> m_snapshot;
+
     friend class POLoadParser;
+    friend class POCatalogSnapshot;
+};
+
+
+/**
+    Streaming reader of PO files' entries.
+
+    Unlike POCatalog, this doesn't build any in-memory representation of
+    the file, it only reports its entries one by one. Use it for read-only
+    processing of many files (e.g. project-wide search), where a full
+    POCatalog isn't needed.
+ */
+class POStreamReader
+{
+public:
+    /// Content of a single entry, as POCatalog would see it
+    struct Entry
+    {
+        wxString context;
+        bool hasContext = false;
+        wxString source;
+        wxString sourcePlural;
+        bool hasPlural = false;
+        wxArrayString translations;
+        bool isFuzzy = false;
+        unsigned lineNumber = 0;
+    };
+
+    explicit POStreamReader(const wxString& filename) : m_filename(filename) {}
+
+    /**
+        Calls @a callback for every entry in the file, in document order.
+        The header entry is skipped. Parsing stops early if @a callback
+        returns false.
+
+        @return false if the file couldn't be read, true otherwise
+     */
+    bool ForEachEntry(const std::function<bool(const Entry&)>& callback);
+
+private:
+    wxString m_filename;
 };
 
 
@@ -0,0 +1,543 @@
+/*
+ *  This file is part of Poedit (https://poedit.net)
+ *
+ *  Copyright (C) 2020 Vaclav Slavik
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "catalog_snapshot.h"
+
+#include "catalog_po.h"
+#include "concurrency.h"
+#include "utility.h"
+
+#include <wx/file.h>
+#include <wx/filename.h>
+#include <wx/log.h>
+#include <wx/translation.h>
+
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+
+
+namespace
+{
+
+// Increment whenever the stored data or POCatalog's parsing change
+const uint32_t SNAPSHOT_FORMAT = 1;
+
+const char SNAPSHOT_MAGIC[8] = {'P','o','e','d','i','t','P','S'};
+const char VALIDATION_MAGIC[8] = {'P','o','e','d','i','t','P','V'};
+
+// Smaller files are parsed fast enough, there's no point in caching them
+const uint64_t SNAPSHOT_MIN_FILE_SIZE = 256 * 1024;
+const size_t SNAPSHOT_MAX_SIZE = 1024 * 1024 * 1024;
+
+// Limits of total size of all stored snapshots (of either kind); least
+// recently used ones are deleted when exceeded
+const uint64_t SNAPSHOTS_MAX_TOTAL_SIZE = 512 * 1024 * 1024;
+const uint64_t VALIDATIONS_MAX_TOTAL_SIZE = 16 * 1024 * 1024;
+
+const size_t HASH_BUFFER_SIZE = 1024 * 1024;
+
+
+class SnapshotWriter
+{
+public:
+    explicit SnapshotWriter(const char *magic) : m_data(magic, sizeof(SNAPSHOT_MAGIC)) {}
+
+    template<typename T>
+    void Write(T value)
+    {
+        m_data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void Write(const std::string& s)
+    {
+        Write((uint32_t)s.size());
+        m_data.append(s);
+    }
+
+    void Write(const wxString& s)
+    {
+        const auto utf8 = s.utf8_str();
+        Write((uint32_t)utf8.length());
+        m_data.append(utf8.data(), utf8.length());
+    }
+
+    void Write(const wxArrayString& a)
+    {
+        Write((uint32_t)a.size());
+        for (auto& s: a)
+            Write(s);
+    }
+
+    /// Returns the data, terminated with their checksum
+    std::string Finish()
+    {
+        Write(fnv1a(m_data.data(), m_data.size()));
+        return std::move(m_data);
+    }
+
+private:
+    std::string m_data;
+};
+
+
+// Bounds-checked reading of the serialized data; the data are untrusted
+class SnapshotReader
+{
+public:
+    explicit SnapshotReader(const std::string& data) : m_data(data), m_pos(0), m_end(0) {}
+
+    /// Verifies the magic and checksum; must be called before reading anything
+    bool Open(const char *magic)
+    {
+        if (m_data.size() < sizeof(SNAPSHOT_MAGIC) + sizeof(uint64_t))
+            return false;
+        if (memcmp(m_data.data(), magic, sizeof(SNAPSHOT_MAGIC)) != 0)
+            return false;
+
+        uint64_t checksum;
+        m_end = m_data.size() - sizeof(checksum);
+        memcpy(&checksum, m_data.data() + m_end, sizeof(checksum));
+        if (checksum != fnv1a(m_data.data(), m_end))
+            return false;
+
+        m_pos = sizeof(SNAPSHOT_MAGIC);
+        return true;
+    }
+
+    bool AtEnd() const { return m_pos == m_end; }
+
+    template<typename T>
+    bool Read(T& value)
+    {
+        if (m_end - m_pos < sizeof(T))
+            return false;
+        memcpy(&value, m_data.data() + m_pos, sizeof(T));
+        m_pos += sizeof(T);
+        return true;
+    }
+
+    bool Read(std::string& s)
+    {
+        uint32_t len;
+        if (!Read(len) || m_end - m_pos < len)
+            return false;
+        s.assign(m_data, m_pos, len);
+        m_pos += len;
+        return true;
+    }
+
+    bool Read(wxString& s)
+    {
+        uint32_t len;
+        if (!Read(len) || m_end - m_pos < len)
+            return false;
+        // the checksum matched, so this is UTF-8 data written by us:
+        s = wxString::FromUTF8Unchecked(m_data.data() + m_pos, len);
+        m_pos += len;
+        return true;
+    }
+
+    bool Read(wxArrayString& a)
+    {
+        uint32_t count;
+        if (!ReadCount(count, sizeof(uint32_t)))
+            return false;
+        a.clear();
+        a.reserve(count);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            wxString s;
+            if (!Read(s))
+                return false;
+            a.push_back(s);
+        }
+        return true;
+    }
+
+    /// Reads count of elements, each taking at least @a minSize bytes
+    bool ReadCount(uint32_t& count, size_t minSize)
+    {
+        // check against remaining size to not allocate nonsense
+        return Read(count) && count <= (m_end - m_pos) / minSize;
+    }
+
+private:
+    const std::string& m_data;
+    size_t m_pos, m_end;
+};
+
+
+bool ReadFile(const wxString& filename, std::string& data)
+{
+    if (!wxFileName::FileExists(filename))
+        return false;
+
+    std::ifstream f(filename.fn_str(), std::ios::in | std::ios::binary);
+    if (!f)
+        return false;
+    std::ostringstream s;
+    s << f.rdbuf();
+    data = s.str();
+    return data.size() <= SNAPSHOT_MAX_SIZE;
+}
+
+void WriteFileAsync(const wxString& filename, std::shared_ptr<std::string> data, uint64_t maxTotalSize)
+{
+    dispatch::async([=]
+    {
+        wxLogNull null;  // failure to write the cache isn't a problem for the user
+        TempOutputFileFor tempfile(filename);
+        {
+            std::ofstream f(tempfile.FileName().fn_str(), std::ios::out | std::ios::binary);
+            f.write(data->data(), data->size());
+            if (!f)
+                return;
+        }
+        tempfile.Commit();
+
+        wxFileName fn(filename);
+        TrimCacheDir(fn.GetPath(), "*." + fn.GetExt(), maxTotalSize);
+    });
+}
+
+// Marks the file as recently used, for TrimCacheDir()
+void TouchFile(const wxString& filename)
+{
+    wxLogNull null;
+    wxFileName(filename).Touch();
+}
+
+// Messages in the snapshot are localized, so it's only valid for the same UI language
+std::string GetUILanguage()
+{
+    auto trans = wxTranslations::Get();
+    return trans ? trans->GetBestTranslation("poedit").ToStdString() : std::string();
+}
+
+wxString GetSnapshotFileName(const wxString& po_file, const char *ext)
+{
+    const auto path = MakeFileName(po_file).GetFullPath().utf8_str();
+    return wxString::Format("%s%c%016llx.%s",
+                            GetCacheDir("Catalogs"), wxFILE_SEP_PATH,
+                            (unsigned long long)fnv1a(path.data(), path.length()),
+                            ext);
+}
+
+} // anonymous namespace
+
+
+bool POCatalogSnapshot::IsUsefulFor(const wxString& po_file)
+{
+    wxLogNull null;
+    const auto size = wxFileName::GetSize(po_file);
+    return size != wxInvalidSize && size.GetValue() >= SNAPSHOT_MIN_FILE_SIZE;
+}
+
+
+POCatalogSnapshot::POCatalogSnapshot(const wxString& po_file)
+    : m_filename(po_file), m_size(0), m_mtime(0), m_contentHash(0)
+{
+    wxLogNull null;
+
+    wxFileName fn(po_file);
+    auto mtime = fn.GetModTime();
+    if (!mtime.IsValid())
+        return;
+    m_mtime = mtime.GetValue().GetValue();
+
+    wxFile f(po_file);
+    if (!f.IsOpened())
+        return;
+
+    std::unique_ptr<char[]> buffer(new char[HASH_BUFFER_SIZE]);
+    uint64_t hash = fnv1a(nullptr, 0);
+    for (;;)
+    {
+        auto len = f.Read(buffer.get(), HASH_BUFFER_SIZE);
+        if (len == wxInvalidOffset)
+            return;
+        if (len == 0)
+            break;
+        hash = fnv1a(buffer.get(), len, hash);
+        m_size += len;
+    }
+
+    m_contentHash = hash ? hash : 1; // 0 means invalid
+}
+
+
+std::string POCatalogSnapshot::MakeKey() const
+{
+    return std::to_string(SNAPSHOT_FORMAT) + ";" +
+           std::to_string(m_size) + ";" +
+           std::to_string(m_mtime) + ";" +
+           std::to_string(m_contentHash);
+}
+
+
+bool POCatalogSnapshot::Restore(POCatalog& catalog)
+{
+    if (!IsOk())
+        return false;
+
+    const auto filename = GetSnapshotFileName(m_filename, "posnap");
+    std::string data;
+    if (!ReadFile(filename, data))
+        return false;
+
+    SnapshotReader r(data);
+    if (!r.Open(SNAPSHOT_MAGIC))
+        return false;
+
+    std::string key;
+    if (!r.Read(key) || key != MakeKey())
+    {
+        // the file changed since, the snapshot is useless now
+        wxLogNull null;
+        wxRemoveFile(filename);
+        return false;
+    }
+
+    // read everything first, the catalog is only modified if all is well:
+    wxString charset, rawHeader, headerComment;
+    uint8_t hasHeader;
+    std::string sourceLanguage;
+    int32_t crlf, wrappingWidth;
+    if (!r.Read(charset) || !r.Read(hasHeader) || !r.Read(rawHeader) || !r.Read(headerComment) ||
+        !r.Read(sourceLanguage) || !r.Read(crlf) || !r.Read(wrappingWidth))
+    {
+        return false;
+    }
+    if (crlf < wxTextFileType_None || crlf > wxTextFileType_Os2)
+        return false;
+
+    uint32_t itemsCount;
+    if (!r.ReadCount(itemsCount, 32))
+        return false;
+
+    std::vector<POCatalogItemPtr> items;
+    items.reserve(itemsCount);
+    for (uint32_t i = 0; i < itemsCount; i++)
+    {
+        uint8_t hasPlural, hasContext;
+        wxString msgid, plural, context, flags, comment;
+        uint32_t lineNumber;
+        wxArrayString translations, references, extractedComments, oldMsgid;
+        if (!r.Read(hasPlural) || !r.Read(hasContext) ||
+            !r.Read(msgid) || !r.Read(plural) || !r.Read(context) ||
+            !r.Read(flags) || !r.Read(comment) || !r.Read(lineNumber) ||
+            !r.Read(translations) || !r.Read(references) ||
+            !r.Read(extractedComments) || !r.Read(oldMsgid))
+        {
+            return false;
+        }
+
+        // do the same as POLoadParser does:
+        auto d = std::make_shared<POCatalogItem>();
+        d->SetId(int(i + 1));
+        if (!flags.empty())
+            d->SetFlags(flags);
+        d->SetString(msgid);
+        if (hasPlural)
+            d->SetPluralString(plural);
+        if (hasContext)
+            d->SetContext(context);
+        d->SetTranslations(translations);
+        d->SetComment(comment);
+        d->SetLineNumber(int(lineNumber));
+        d->SetRawReferences(references);
+        for (auto& c: extractedComments)
+            d->AddExtractedComments(c);
+        d->SetOldMsgid(oldMsgid);
+        items.push_back(d);
+    }
+
+    uint32_t deletedCount;
+    if (!r.ReadCount(deletedCount, 20))
+        return false;
+
+    POCatalogDeletedDataArray deletedItems;
+    deletedItems.reserve(deletedCount);
+    for (uint32_t i = 0; i < deletedCount; i++)
+    {
+        wxArrayString lines, extractedComments;
+        wxString flags, comment;
+        int32_t lineNumber;
+        if (!r.Read(lines) || !r.Read(flags) || !r.Read(comment) ||
+            !r.Read(extractedComments) || !r.Read(lineNumber))
+        {
+            return false;
+        }
+
+        POCatalogDeletedData d(lines);
+        if (!flags.empty())
+            d.SetFlags(flags);
+        d.SetComment(comment);
+        d.SetLineNumber(lineNumber);
+        for (auto& c: extractedComments)
+            d.AddExtractedComments(c);
+        deletedItems.push_back(d);
+    }
+
+    if (!r.AtEnd())
+        return false;
+
+    if (hasHeader)
+    {
+        catalog.m_header.FromString(rawHeader);
+        catalog.m_header.Comment = headerComment;
+    }
+    catalog.m_header.Charset = charset;
+    for (auto& i: items)
+        catalog.AddItem(i);
+    catalog.m_deletedItems = std::move(deletedItems);
+    catalog.m_sourceLanguage = Language::TryParse(sourceLanguage);
+    catalog.m_fileCRLF = (wxTextFileType)crlf;
+    catalog.m_fileWrappingWidth = wrappingWidth;
+
+    TouchFile(filename);
+    wxLogTrace("poedit", "restored %s from snapshot", m_filename);
+    return true;
+}
+
+
+void POCatalogSnapshot::Store(const POCatalog& catalog, bool hasHeader, const wxString& rawHeader)
+{
+    if (!IsOk())
+        return;
+
+    SnapshotWriter w(SNAPSHOT_MAGIC);
+    w.Write(MakeKey());
+
+    w.Write(catalog.m_header.Charset);
+    w.Write((uint8_t)hasHeader);
+    w.Write(rawHeader);
+    w.Write(catalog.m_header.Comment);
+    w.Write(catalog.m_sourceLanguage.Code());
+    w.Write((int32_t)catalog.m_fileCRLF);
+    w.Write((int32_t)catalog.m_fileWrappingWidth);
+
+    w.Write((uint32_t)catalog.m_items.size());
+    for (auto& i: catalog.m_items)
+    {
+        auto& item = static_cast<const POCatalogItem&>(*i);
+        w.Write((uint8_t)item.HasPlural());
+        w.Write((uint8_t)item.HasContext());
+        w.Write(item.GetString());
+        w.Write(item.GetPluralString());
+        w.Write(item.GetContext());
+        w.Write(item.GetFlags());
+        w.Write(item.GetComment());
+        w.Write((uint32_t)item.GetLineNumber());
+        w.Write(item.GetTranslations());
+        w.Write(item.GetRawReferences());
+        w.Write(item.GetExtractedComments());
+        w.Write(item.GetOldMsgidRaw());
+    }
+
+    w.Write((uint32_t)catalog.m_deletedItems.size());
+    for (auto& d: catalog.m_deletedItems)
+    {
+        w.Write(d.GetDeletedLines());
+        w.Write(d.GetFlags());
+        w.Write(d.GetComment());
+        w.Write(d.GetExtractedComments());
+        w.Write((int32_t)d.GetLineNumber());
+    }
+
+    WriteFileAsync(GetSnapshotFileName(m_filename, "posnap"), std::make_shared<std::string>(w.Finish()),
+                   SNAPSHOTS_MAX_TOTAL_SIZE);
+}
+
+
+bool POCatalogSnapshot::RestoreValidation(GettextErrors& errors)
+{
+    if (!IsOk())
+        return false;
+
+    const auto filename = GetSnapshotFileName(m_filename, "msgfmt");
+    std::string data;
+    if (!ReadFile(filename, data))
+        return false;
+
+    SnapshotReader r(data);
+    if (!r.Open(VALIDATION_MAGIC))
+        return false;
+
+    std::string key, uiLang;
+    if (!r.Read(key) || key != MakeKey())
+    {
+        wxLogNull null;
+        wxRemoveFile(filename);
+        return false;
+    }
+    if (!r.Read(uiLang) || uiLang != GetUILanguage())
+        return false;
+
+    uint32_t count;
+    if (!r.ReadCount(count, 8))
+        return false;
+
+    GettextErrors results;
+    results.reserve(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        GettextError e;
+        int32_t line;
+        if (!r.Read(line) || !r.Read(e.text))
+            return false;
+        e.line = line;
+        results.push_back(e);
+    }
+
+    if (!r.AtEnd())
+        return false;
+
+    TouchFile(filename);
+    errors = std::move(results);
+    return true;
+}
+
+
+void POCatalogSnapshot::StoreValidation(const GettextErrors& errors)
+{
+    if (!IsOk())
+        return;
+
+    SnapshotWriter w(VALIDATION_MAGIC);
+    w.Write(MakeKey());
+    w.Write(GetUILanguage());
+    w.Write((uint32_t)errors.size());
+    for (auto& e: errors)
+    {
+        w.Write((int32_t)e.line);
+        w.Write(e.text);
+    }
+
+    WriteFileAsync(GetSnapshotFileName(m_filename, "msgfmt"), std::make_shared<std::string>(w.Finish()),
+                   VALIDATIONS_MAX_TOTAL_SIZE);
+}
@@ -0,0 +1,89 @@
+/*
+ *  This file is part of Poedit (https://poedit.net)
+ *
+ *  Copyright (C) 2020 Vaclav Slavik
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef Poedit_catalog_snapshot_h
+#define Poedit_catalog_snapshot_h
+
+#include "gexecute.h"
+
+#include <wx/string.h>
+
+#include <cstdint>
+#include <string>
+
+class POCatalog;
+
+
+/**
+    On-disk cache of parsed PO files.
+
+    Parsing of large PO files takes seconds, so POCatalog stores the result
+    of parsing in user's cache directory and reuses it when the same file is
+    opened again, as long as it didn't change. Snapshots are keyed by file's
+    path and only used if the file's size, modification time and content hash
+    match. Anything wrong with the snapshot (missing, corrupted, different
+    format version) means it's not used and the file is parsed as usual.
+    Outdated snapshots are deleted and the least recently used ones are
+    evicted when their total size exceeds a limit.
+ */
+class POCatalogSnapshot
+{
+public:
+    /// Returns true if it makes sense to use snapshots for given file
+    static bool IsUsefulFor(const wxString& po_file);
+
+    /// Prepares snapshot for given file; reads the file to hash its content
+    explicit POCatalogSnapshot(const wxString& po_file);
+
+    /**
+        Restores @a catalog from the snapshot, if there's a valid one.
+        The catalog is only modified if true is returned.
+     */
+    bool Restore(POCatalog& catalog);
+
+    /**
+        Stores just parsed @a catalog in the snapshot. @a rawHeader is the
+        header entry's text as it appears in the file (empty if none).
+        The snapshot is written asynchronously.
+     */
+    void Store(const POCatalog& catalog, bool hasHeader, const wxString& rawHeader);
+
+    /// Loads cached results of msgfmt validation of the file, if any
+    bool RestoreValidation(GettextErrors& errors);
+
+    /// Stores results of msgfmt validation of the file
+    void StoreValidation(const GettextErrors& errors);
+
+private:
+    bool IsOk() const { return m_contentHash != 0; }
+    std::string MakeKey() const;
+
+    wxString m_filename;
+    uint64_t m_size;
+    int64_t m_mtime;
+    uint64_t m_contentHash;
+};
+
+#endif // Poedit_catalog_snapshot_h
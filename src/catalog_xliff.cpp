@@ -25,6 +25,7 @@
 
 #include "catalog_xliff.h"
 
+#include "compression.h"
 #include "qa_checks.h"
 #include "configuration.h"
 #include "str_helpers.h"
@@ -35,6 +36,8 @@
 
 #include <boost/algorithm/string.hpp>
 
+#include <cstring>
+#include <fstream>
 #include <memory>
 #include <mutex>
 #include <set>
@@ -93,8 +96,7 @@ inline std::string get_node_text(xml_node node, bool isPlainText)
 
 inline void apply_placeholders(std::string& s, const XLIFFStringMetadata& metadata)
 {
-    for (auto& ph: metadata.substitutions)
-        boost::replace_all(s, ph.markup, ph.placeholder);
+    metadata.toPlaceholders.Apply(s);
 }
 
 inline std::string get_node_text_with_metadata(xml_node node, const XLIFFStringMetadata& metadata)
@@ -115,8 +117,7 @@ bool set_node_text_with_metadata(xml_node node, std::string&& text, const XLIFFS
     else
     {
         std::string s(std::move(text));
-        for (auto& ph: metadata.substitutions)
-            boost::replace_all(s, ph.placeholder, ph.markup);
+        metadata.toMarkup.Apply(s);
 
         remove_all_children(node);
         auto result = node.append_buffer(s.c_str(), s.size(), parse_default, encoding_utf8);
@@ -280,6 +281,8 @@ protected:
                 }
             }
         }
+
+        metadata.CompileSubstitutions();
     }
 
     inline std::string PrettifyPlaceholder(const std::string& s) const
@@ -348,11 +351,240 @@ protected:
 };
 
 
+typedef XLIFFStreamReader::Unit XLIFFUnit;
+
+// Reads content of XLIFF 1.x <trans-unit> element
+void read_xliff12_unit(xml_node node, XLIFFStringMetadata& metadata, XLIFFUnit& u)
+{
+    auto source = node.child("source");
+
+    XLIFF12MetadataExtractor extractor;
+    source.traverse(extractor);
+    metadata = std::move(extractor.metadata);
+
+    u.source = str::to_wx(extractor.extractedText);
+
+    // TODO: switch to textual IDs in CatalogItem
+    std::string id = node.attribute("id").value();
+    // some tools (e.g. Xcode, tool-id="com.apple.dt.xcode") use ID same as text
+    if (!id.empty() && id != u.source)
+        u.extractedComments.push_back("ID: " + str::to_wx(id));
+
+    auto target = node.child("target");
+    if (target)
+    {
+        u.translation = str::to_wx(get_node_text_with_metadata(target, metadata));
+        u.isTranslated = !u.translation.empty();
+        std::string state = target.attribute("state").value();
+        if (state == "needs-adaptation" || state == "needs-l10n")
+            u.isFuzzy = true;
+        else if (u.isTranslated && (state == "new" || state == "needs-translation"))
+            u.isFuzzy = true;
+    }
+
+    for (auto note: node.children("note"))
+    {
+        std::string noteText = note.text().get();
+        if (noteText == "No comment provided by engineer.")  // Xcode does that
+            continue;
+
+        if (!u.extractedComments.empty())
+            u.extractedComments.push_back("");
+        u.extractedComments.push_back(str::to_wx(noteText));
+    }
+}
+
+// Reads content of XLIFF 2.0 <segment> element
+void read_xliff2_segment(xml_node node, XLIFFStringMetadata& metadata, XLIFFUnit& u)
+{
+    auto unit = node.parent();
+    auto source = node.child("source");
+
+    XLIFF2MetadataExtractor extractor;
+    source.traverse(extractor);
+    metadata = std::move(extractor.metadata);
+
+    u.source = str::to_wx(extractor.extractedText);
+
+    // TODO: switch to textual IDs in CatalogItem
+    std::string id = unit.attribute("id").value();
+    // some tools (e.g. Xcode, tool-id="com.apple.dt.xcode") use ID same as text
+    if (!id.empty() && id != u.source)
+        u.extractedComments.push_back("ID: " + str::to_wx(id));
+
+    auto target = node.child("target");
+    if (target)
+    {
+        u.translation = str::to_wx(get_node_text_with_metadata(target, metadata));
+        u.isTranslated = !u.translation.empty();
+    }
+
+    std::string state = node.attribute("state").value();
+    std::string substate = node.attribute("subState").value();
+    u.isFuzzy = (u.isTranslated && state == "initial") || (substate == "poedit:fuzzy");
+
+    for (auto note: unit.select_nodes(".//note[not(@category='location')]"))
+    {
+        std::string noteText = note.node().text().get();
+
+        if (!u.extractedComments.empty())
+            u.extractedComments.push_back("");
+        u.extractedComments.push_back(str::to_wx(noteText));
+    }
+}
+
+// Can occurrences of the two strings in a text overlap or share characters?
+bool can_overlap(const std::string& a, const std::string& b)
+{
+    if (a.empty() || b.empty())
+        return true; // replacing with nothing joins the text around it
+    if (a.find(b) != std::string::npos || b.find(a) != std::string::npos)
+        return true;
+    const size_t maxLen = std::min(a.size(), b.size());
+    for (size_t len = 1; len < maxLen; ++len)
+    {
+        if (a.compare(a.size() - len, len, b, 0, len) == 0 ||
+            b.compare(b.size() - len, len, a, 0, len) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
 
 } // anonymous namespace
 
 
 
+void MultiReplacer::Add(const std::string& from, const std::string& to)
+{
+    if (from.empty())
+        return;
+
+    // Replacing in one pass gives different results than sequential
+    // replace_all() if the new pattern overlaps with an earlier pattern or
+    // could match (a part of) an earlier pattern's replacement:
+    if (!m_sequential)
+    {
+        for (auto& p: m_patterns)
+        {
+            if (can_overlap(p.first, from) || can_overlap(p.second, from))
+            {
+                m_sequential = true;
+                break;
+            }
+        }
+    }
+    m_patterns.emplace_back(from, to);
+
+    int node = 0;
+    for (char c: from)
+    {
+        int child = FindChild(node, c);
+        if (child == -1)
+        {
+            child = (int)m_nodes.size();
+            m_nodes.emplace_back();
+            m_nodes[node].children.emplace_back(c, child);
+        }
+        node = child;
+    }
+
+    // if the same pattern was already added, the first one wins
+    if (m_nodes[node].match == -1)
+    {
+        m_nodes[node].match = (int)m_replacements.size();
+        m_replacements.push_back(to);
+    }
+    m_firstChars[(unsigned char)from.front()] = true;
+}
+
+
+void MultiReplacer::ApplySequentially(std::string& s) const
+{
+    for (auto& p: m_patterns)
+        boost::replace_all(s, p.first, p.second);
+}
+
+
+void MultiReplacer::Apply(std::string& s) const
+{
+    if (m_replacements.empty())
+        return;
+
+    if (m_sequential)
+    {
+        ApplySequentially(s);
+        return;
+    }
+
+    std::string out;
+    bool changed = false;
+    size_t copied = 0;
+    const size_t len = s.size();
+
+    for (size_t i = 0; i < len; )
+    {
+        if (!m_firstChars[(unsigned char)s[i]])
+        {
+            ++i;
+            continue;
+        }
+
+        // find the earliest added pattern that matches at this position:
+        int best = -1;
+        size_t bestLen = 0;
+        int node = 0;
+        for (size_t j = i; j < len; ++j)
+        {
+            node = FindChild(node, s[j]);
+            if (node == -1)
+                break;
+            const int match = m_nodes[node].match;
+            if (match != -1 && (best == -1 || match < best))
+            {
+                best = match;
+                bestLen = j - i + 1;
+            }
+        }
+
+        if (best == -1)
+        {
+            ++i;
+            continue;
+        }
+
+        if (!changed)
+        {
+            out.reserve(len);
+            changed = true;
+        }
+        out.append(s, copied, i - copied);
+        out += m_replacements[best];
+        i += bestLen;
+        copied = i;
+    }
+
+    if (changed)
+    {
+        out.append(s, copied, std::string::npos);
+        s.swap(out);
+    }
+}
+
+
+void XLIFFStringMetadata::CompileSubstitutions()
+{
+    toPlaceholders = MultiReplacer();
+    toMarkup = MultiReplacer();
+    for (auto& ph: substitutions)
+    {
+        toPlaceholders.Add(ph.markup, ph.placeholder);
+        toMarkup.Add(ph.placeholder, ph.markup);
+    }
+}
+
+
 XLIFFReadException::XLIFFReadException(const wxString& filename, const wxString& what)
     : XLIFFException(wxString::Format(_(L"Error loading file “%s”: %s."), filename, what))
 {}
@@ -384,7 +616,17 @@ std::shared_ptr<XLIFFCatalog> XLIFFCatalog::Open(const wxString& filename)
     constexpr auto parse_flags = parse_full | parse_ws_pcdata | parse_fragment;
 
     xml_document doc;
-    auto result = doc.load_file(filename.fn_str(), parse_flags);
+    xml_parse_result result;
+    if (IsGzipFileName(filename))
+    {
+        // decompress on the fly, without an intermediate uncompressed copy:
+        auto in = OpenInputStream(filename);
+        result = doc.load(*in, parse_flags);
+    }
+    else
+    {
+        result = doc.load_file(filename.fn_str(), parse_flags);
+    }
     if (!result)
         throw XLIFFReadException(filename, result.description());
 
@@ -422,9 +664,19 @@ bool XLIFFCatalog::Save(const wxString& filename, bool /*save_mo*/,
 
     TempOutputFileFor tempfile(filename);
 
-    m_doc.save_file(tempfile.FileName().fn_str(), "\t", format_raw);
+    bool ok = true;
+    if (IsGzipFileName(filename))
+    {
+        GzipOutputStream out(tempfile.FileName());
+        m_doc.save(out, "\t", format_raw);
+        ok = out.Close();
+    }
+    else
+    {
+        m_doc.save_file(tempfile.FileName().fn_str(), "\t", format_raw);
+    }
 
-    if ( !tempfile.Commit() )
+    if ( !ok || !tempfile.Commit() )
     {
         wxLogError(_(L"Couldn’t save file %s."), filename.c_str());
         return false;
@@ -461,8 +713,14 @@ Catalog::ValidationResults XLIFFCatalog::Validate(bool)
 }
 
 
-
-
+void XLIFFCatalogItem::InitFromUnit(XLIFFStreamReader::Unit&& u)
+{
+    m_string = std::move(u.source);
+    m_translations.push_back(std::move(u.translation));
+    m_isTranslated = u.isTranslated;
+    m_isFuzzy = u.isFuzzy;
+    m_extractedComments = std::move(u.extractedComments);
+}
 
 
 class XLIFF12CatalogItem : public XLIFFCatalogItem
@@ -470,47 +728,9 @@ class XLIFF12CatalogItem : public XLIFFCatalogItem
 public:
     XLIFF12CatalogItem(int itemId, xml_node node) : XLIFFCatalogItem(itemId, node)
     {
-        auto source = node.child("source");
-
-        XLIFF12MetadataExtractor extractor;
-        source.traverse(extractor);
-        m_metadata = std::move(extractor.metadata);
-
-        m_string = str::to_wx(extractor.extractedText);
-
-        // TODO: switch to textual IDs in CatalogItem
-        std::string id = node.attribute("id").value();
-        // some tools (e.g. Xcode, tool-id="com.apple.dt.xcode") use ID same as text
-        if (!id.empty() && id != m_string)
-            m_extractedComments.push_back("ID: " + str::to_wx(id));
-
-        auto target = node.child("target");
-        if (target)
-        {
-            auto trans_text = str::to_wx(get_node_text_with_metadata(target, m_metadata));
-            m_translations.push_back(trans_text);
-            m_isTranslated = !trans_text.empty();
-            std::string state = target.attribute("state").value();
-            if (state == "needs-adaptation" || state == "needs-l10n")
-                m_isFuzzy = true;
-            else if (m_isTranslated && (state == "new" || state == "needs-translation"))
-                m_isFuzzy = true;
-        }
-        else
-        {
-            m_translations.push_back("");
-        }
-
-        for (auto note: node.children("note"))
-        {
-            std::string noteText = note.text().get();
-            if (noteText == "No comment provided by engineer.")  // Xcode does that
-                continue;
-
-            if (!m_extractedComments.empty())
-                m_extractedComments.push_back("");
-            m_extractedComments.push_back(str::to_wx(noteText));
-        }
+        XLIFFUnit u;
+        read_xliff12_unit(node, m_metadata, u);
+        InitFromUnit(std::move(u));
     }
 
     void UpdateInternalRepresentation() override
@@ -637,44 +857,9 @@ class XLIFF2CatalogItem : public XLIFFCatalogItem
 public:
     XLIFF2CatalogItem(int itemId, xml_node node) : XLIFFCatalogItem(itemId, node)
     {
-        auto source = node.child("source");
-
-        XLIFF2MetadataExtractor extractor;
-        source.traverse(extractor);
-        m_metadata = std::move(extractor.metadata);
-
-        m_string = str::to_wx(extractor.extractedText);
-
-        // TODO: switch to textual IDs in CatalogItem
-        std::string id = unit().attribute("id").value();
-        // some tools (e.g. Xcode, tool-id="com.apple.dt.xcode") use ID same as text
-        if (!id.empty() && id != m_string)
-            m_extractedComments.push_back("ID: " + str::to_wx(id));
-
-        auto target = node.child("target");
-        if (target)
-        {
-            auto trans_text = str::to_wx(get_node_text_with_metadata(target, m_metadata));
-            m_translations.push_back(trans_text);
-            m_isTranslated = !trans_text.empty();
-        }
-        else
-        {
-            m_translations.push_back("");
-        }
-
-        std::string state = node.attribute("state").value();
-        std::string substate = node.attribute("subState").value();
-        m_isFuzzy = (m_isTranslated && state == "initial") || (substate == "poedit:fuzzy");
-
-        for (auto note: unit().select_nodes(".//note[not(@category='location')]"))
-        {
-            std::string noteText = note.node().text().get();
-
-            if (!m_extractedComments.empty())
-                m_extractedComments.push_back("");
-            m_extractedComments.push_back(str::to_wx(noteText));
-        }
+        XLIFFUnit u;
+        read_xliff2_segment(node, m_metadata, u);
+        InitFromUnit(std::move(u));
     }
 
     void UpdateInternalRepresentation() override
@@ -756,3 +941,374 @@ void XLIFF2Catalog::SetLanguage(Language lang)
     XLIFFCatalog::SetLanguage(lang);
     attribute(GetXMLRoot(), "trgLang") = lang.LanguageTag().c_str();
 }
+
+
+namespace
+{
+
+/**
+    Minimal forward-only scanner of XML markup that reads the file in chunks.
+
+    Only element tags are reported, everything else (text, comments, CDATA
+    sections, processing instructions, DTD) is skipped over. Processed data
+    are discarded from the buffer, except for the marked region that the
+    caller wants to retrieve later.
+ */
+class XMLTagScanner
+{
+public:
+    enum class Tag { Start, Empty, End, None };
+
+    // Thrown if the file isn't in UTF-8, which is all the scanner handles
+    struct UnsupportedEncoding {};
+
+    XMLTagScanner(const wxString& filename)
+        : m_filename(filename),
+          m_file(OpenInputStream(filename)),
+          m_pos(0), m_tagStart(0), m_markPos(std::string::npos)
+    {
+        if (!*m_file)
+            throw XLIFFReadException(filename, _(L"file couldn’t be opened"));
+
+        EnsureAvailable(2);
+        if (m_buf.size() >= 2 && (m_buf[0] == '\0' || m_buf[1] == '\0' ||
+                                  m_buf.compare(0, 2, "\xFF\xFE") == 0 ||
+                                  m_buf.compare(0, 2, "\xFE\xFF") == 0))
+        {
+            throw UnsupportedEncoding();  // UTF-16 or UTF-32
+        }
+    }
+
+    /// Advances to the next element tag, returns Tag::None at the end of the file.
+    Tag Next()
+    {
+        Compact();
+        for (;;)
+        {
+            size_t lt = Find("<", m_pos);
+            if (lt == std::string::npos)
+                return Tag::None;
+            m_pos = lt;
+
+            EnsureAvailable(9);
+            if (StartsWith("<!--"))
+                SkipPast("-->");
+            else if (StartsWith("<![CDATA["))
+                SkipPast("]]>");
+            else if (StartsWith("<?xml"))
+                SkipXMLDeclaration();
+            else if (StartsWith("<?"))
+                SkipPast("?>");
+            else if (StartsWith("<!"))
+                m_pos = FindMarkupEnd() + 1; // DOCTYPE
+            else
+                return ReadTag();
+        }
+    }
+
+    /// Name of the tag returned by last Next() call
+    const std::string& TagName() const { return m_tagName; }
+
+    /// Value of the current tag's attribute (not unescaped) or empty string
+    std::string Attribute(const char *name) const
+    {
+        const size_t end = m_pos - 1;
+        size_t i = m_tagStart + 1 + m_tagName.size();
+        while (i < end)
+        {
+            i = m_buf.find_first_not_of(" \t\r\n", i);
+            if (i >= end)
+                break;
+            size_t eq = m_buf.find('=', i);
+            if (eq >= end)
+                break;
+            size_t quote = m_buf.find_first_of("\"'", eq);
+            if (quote >= end)
+                break;
+            size_t quoteEnd = m_buf.find(m_buf[quote], quote + 1);
+            if (quoteEnd >= end)
+                break;
+            size_t nameEnd = m_buf.find_last_not_of(" \t\r\n", eq - 1) + 1;
+            if (m_buf.compare(i, nameEnd - i, name) == 0)
+                return m_buf.substr(quote + 1, quoteEnd - quote - 1);
+            i = quoteEnd + 1;
+        }
+        return std::string();
+    }
+
+    /// Starts recording markup at the current tag
+    void MarkTag() { m_markPos = m_tagStart; }
+
+    /// Returns recorded markup up to the end of the current tag and stops recording
+    std::string TakeMarked()
+    {
+        auto s = m_buf.substr(m_markPos, m_pos - m_markPos);
+        m_markPos = std::string::npos;
+        return s;
+    }
+
+private:
+    static const size_t CHUNK_SIZE = 64 * 1024;
+
+    bool Fill()
+    {
+        if (!*m_file)
+            return false;
+        const size_t oldSize = m_buf.size();
+        m_buf.resize(oldSize + CHUNK_SIZE);
+        m_file->read(&m_buf[oldSize], CHUNK_SIZE);
+        const size_t count = (size_t)m_file->gcount();
+        m_buf.resize(oldSize + count);
+        if (m_file->bad())
+            throw XLIFFReadException(m_filename, _(L"file couldn’t be read"));
+        return count > 0;
+    }
+
+    void EnsureAvailable(size_t count)
+    {
+        while (m_buf.size() < m_pos + count && Fill()) {}
+    }
+
+    // Drops already processed data from the buffer
+    void Compact()
+    {
+        const size_t keep = std::min(m_pos, m_markPos);
+        if (keep < CHUNK_SIZE)
+            return;
+        m_buf.erase(0, keep);
+        m_pos -= keep;
+        m_tagStart = m_pos;
+        if (m_markPos != std::string::npos)
+            m_markPos -= keep;
+    }
+
+    size_t Find(const char *str, size_t from)
+    {
+        const size_t len = strlen(str);
+        for (;;)
+        {
+            auto found = m_buf.find(str, from);
+            if (found != std::string::npos)
+                return found;
+            // the string may straddle the boundary with the next chunk:
+            if (m_buf.size() + 1 > from + len)
+                from = m_buf.size() + 1 - len;
+            if (!Fill())
+                return std::string::npos;
+        }
+    }
+
+    bool StartsWith(const char *prefix) const
+    {
+        return m_buf.compare(m_pos, strlen(prefix), prefix) == 0;
+    }
+
+    void SkipPast(const char *str)
+    {
+        size_t found = Find(str, m_pos);
+        if (found == std::string::npos)
+            ThrowUnexpectedEnd();
+        m_pos = found + strlen(str);
+    }
+
+    // Finds the closing '>' of markup at m_pos, ignoring it in quoted values
+    // and DOCTYPE's internal subset
+    size_t FindMarkupEnd()
+    {
+        char quote = 0;
+        int brackets = 0;
+        for (size_t i = m_pos + 1; ; ++i)
+        {
+            if (i >= m_buf.size() && !Fill())
+                ThrowUnexpectedEnd();
+            const char c = m_buf[i];
+            if (quote)
+            {
+                if (c == quote)
+                    quote = 0;
+            }
+            else if (c == '"' || c == '\'')
+                quote = c;
+            else if (c == '[')
+                brackets++;
+            else if (c == ']')
+                brackets--;
+            else if (c == '>' && brackets <= 0)
+                return i;
+        }
+    }
+
+    void SkipXMLDeclaration()
+    {
+        size_t end = Find("?>", m_pos);
+        if (end == std::string::npos)
+            ThrowUnexpectedEnd();
+
+        auto decl = m_buf.substr(m_pos, end - m_pos);
+        m_pos = end + 2;
+
+        auto enc = decl.find("encoding");
+        if (enc == std::string::npos)
+            return;
+        auto quote = decl.find_first_of("\"'", enc);
+        if (quote == std::string::npos)
+            return;
+        auto value = boost::to_lower_copy(decl.substr(quote + 1, decl.find(decl[quote], quote + 1) - quote - 1));
+        if (value != "utf-8" && value != "utf8")
+            throw UnsupportedEncoding();
+    }
+
+    Tag ReadTag()
+    {
+        m_tagStart = m_pos;
+        const size_t end = FindMarkupEnd();
+        m_pos = end + 1;
+
+        const bool closing = m_buf[m_tagStart + 1] == '/';
+        const size_t nameStart = m_tagStart + (closing ? 2 : 1);
+        const size_t nameEnd = m_buf.find_first_of(" \t\r\n/>", nameStart);
+        m_tagName.assign(m_buf, nameStart, nameEnd - nameStart);
+
+        if (closing)
+            return Tag::End;
+        return m_buf[end - 1] == '/' ? Tag::Empty : Tag::Start;
+    }
+
+    [[noreturn]] void ThrowUnexpectedEnd()
+    {
+        throw XLIFFReadException(m_filename, _("unexpected end of file"));
+    }
+
+private:
+    wxString m_filename;
+    std::unique_ptr<std::istream> m_file;
+    std::string m_buf;
+    size_t m_pos, m_tagStart, m_markPos;
+    std::string m_tagName;
+};
+
+} // anonymous namespace
+
+
+void XLIFFStreamReader::ForEachUnit(const std::function<void(const Unit&)>& callback)
+{
+    constexpr auto parse_flags = parse_full | parse_ws_pcdata | parse_fragment;
+
+    try
+    {
+        typedef XMLTagScanner::Tag Tag;
+        XMLTagScanner scanner(m_filename);
+
+        Tag tag;
+        do
+        {
+            tag = scanner.Next();
+        } while (tag == Tag::End);
+
+        std::string xliff_version;
+        if (tag != Tag::None && scanner.TagName() == "xliff")
+            xliff_version = scanner.Attribute("version");
+
+        bool isXLIFF2;
+        if (xliff_version == "1.0" || xliff_version == "1.1" || xliff_version == "1.2")
+            isXLIFF2 = false;
+        else if (xliff_version == "2.0")
+            isXLIFF2 = true;
+        else
+            throw XLIFFReadException(m_filename, wxString::Format(_("unsupported XLIFF version (%s)"), xliff_version));
+
+        const char *unitTag = isXLIFF2 ? "unit" : "trans-unit";
+
+        Language srcLang, lang;
+        if (isXLIFF2)
+        {
+            srcLang = Language::TryParse(scanner.Attribute("srcLang"));
+            lang = Language::TryParse(scanner.Attribute("trgLang"));
+        }
+
+        while ((tag = scanner.Next()) != Tag::None)
+        {
+            if (tag == Tag::End)
+                continue;
+
+            if (!isXLIFF2 && scanner.TagName() == "file")
+            {
+                srcLang = Language::TryParse(scanner.Attribute("source-language"));
+                lang = Language::TryParse(scanner.Attribute("target-language"));
+                continue;
+            }
+
+            if (tag != Tag::Start || scanner.TagName() != unitTag)
+                continue;
+
+            // read the entire unit and parse just that fragment:
+            scanner.MarkTag();
+            for (int depth = 1; depth > 0; )
+            {
+                tag = scanner.Next();
+                if (tag == Tag::None)
+                    throw XLIFFReadException(m_filename, _("unexpected end of file"));
+                if (scanner.TagName() == unitTag)
+                {
+                    if (tag == Tag::Start)
+                        depth++;
+                    else if (tag == Tag::End)
+                        depth--;
+                }
+            }
+            auto markup = scanner.TakeMarked();
+
+            xml_document doc;
+            auto result = doc.load_buffer(markup.data(), markup.size(), parse_flags, encoding_utf8);
+            if (!result)
+                throw XLIFFReadException(m_filename, result.description());
+
+            auto node = doc.child(unitTag);
+            if (isXLIFF2)
+            {
+                for (auto segment: node.select_nodes(".//segment"))
+                {
+                    auto segnode = segment.node();
+                    if (strcmp(segnode.parent().attribute("translate").value(), "no") == 0)
+                        continue;
+
+                    Unit u;
+                    u.srcLang = srcLang;
+                    u.lang = lang;
+                    XLIFFStringMetadata metadata;
+                    read_xliff2_segment(segnode, metadata, u);
+                    callback(u);
+                }
+            }
+            else
+            {
+                if (strcmp(node.attribute("translate").value(), "no") == 0)
+                    continue;
+
+                Unit u;
+                u.srcLang = srcLang;
+                u.lang = lang;
+                XLIFFStringMetadata metadata;
+                read_xliff12_unit(node, metadata, u);
+                callback(u);
+            }
+        }
+    }
+    catch (XMLTagScanner::UnsupportedEncoding&)
+    {
+        // rare enough to not bother with streaming, let pugixml handle it
+        auto cat = XLIFFCatalog::Open(m_filename);
+        for (auto& item: cat->items())
+        {
+            Unit u;
+            u.srcLang = cat->GetSourceLanguage();
+            u.lang = cat->GetLanguage();
+            u.source = item->GetString();
+            u.translation = item->GetTranslation();
+            u.isTranslated = item->IsTranslated();
+            u.isFuzzy = item->IsFuzzy();
+            u.extractedComments = item->GetExtractedComments();
+            callback(u);
+        }
+    }
+}
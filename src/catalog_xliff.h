@@ -31,6 +31,8 @@
 
 #include "pugixml.h"
 
+#include <array>
+#include <functional>
 #include <vector>
 
 
@@ -47,6 +49,58 @@ public:
 };
 
 
+/**
+    Replaces occurrences of multiple strings in a single left-to-right pass.
+
+    The result is always the same as with calling boost::replace_all() for
+    each pattern in the order they were added.
+
+    The patterns are compiled into a trie once, so that replacing is fast even
+    for texts with many placeholders. A single pass is only equivalent to
+    sequential replacing if no pattern can overlap with another or with the
+    replacement of an earlier one, e.g. "{1}" in "{{1}}", or "%b%" followed by
+    "%a%" in "%a%b%". Such sets are detected when adding patterns and are
+    replaced sequentially instead.
+ */
+class MultiReplacer
+{
+public:
+    MultiReplacer() : m_nodes(1), m_sequential(false) { m_firstChars.fill(false); }
+
+    /// Adds a pattern to replace; empty patterns are ignored
+    void Add(const std::string& from, const std::string& to);
+
+    void Apply(std::string& s) const;
+
+private:
+    struct Node
+    {
+        std::vector<std::pair<char, int>> children;
+        int match = -1;
+    };
+
+    int FindChild(int node, char c) const
+    {
+        for (auto& ch: m_nodes[node].children)
+        {
+            if (ch.first == c)
+                return ch.second;
+        }
+        return -1;
+    }
+
+    void ApplySequentially(std::string& s) const;
+
+    std::vector<Node> m_nodes;
+    std::vector<std::string> m_replacements;
+    std::array<bool, 256> m_firstChars;
+
+    // all patterns in order, for overlap checks and the sequential fallback
+    std::vector<std::pair<std::string, std::string>> m_patterns;
+    bool m_sequential;
+};
+
+
 // Metadata concerning XLIFF representation in Poedit, e.g. for placeholders
 struct XLIFFStringMetadata
 {
@@ -64,6 +118,51 @@ struct XLIFFStringMetadata
         std::string markup;
     };
     std::vector<Subst> substitutions;
+
+    /// Builds toPlaceholders and toMarkup from substitutions
+    void CompileSubstitutions();
+
+    MultiReplacer toPlaceholders;
+    MultiReplacer toMarkup;
+};
+
+
+/**
+    Streaming, read-only access to XLIFF files.
+
+    Unlike XLIFFCatalog::Open(), this never builds DOM tree of the whole
+    document: the file is scanned in chunks and only one translation unit
+    at a time is parsed, so memory use doesn't depend on the file's size.
+
+    Use it for read-only processing of potentially large files (e.g. TM
+    import or statistics), where a full XLIFFCatalog isn't needed.
+ */
+class XLIFFStreamReader
+{
+public:
+    /// Content of a single translatable string, as XLIFFCatalog would see it
+    struct Unit
+    {
+        Language srcLang, lang;
+        wxString source;
+        wxString translation;
+        bool isTranslated = false;
+        bool isFuzzy = false;
+        wxArrayString extractedComments;
+    };
+
+    explicit XLIFFStreamReader(const wxString& filename) : m_filename(filename) {}
+
+    /**
+        Calls @a callback for every translatable string in the file, in
+        document order. Units marked as translate="no" are skipped.
+
+        Throws XLIFFReadException on error.
+     */
+    void ForEachUnit(const std::function<void(const Unit&)>& callback);
+
+private:
+    wxString m_filename;
 };
 
 
@@ -75,6 +174,8 @@ public:
     XLIFFCatalogItem(const CatalogItem&) = delete;
 
 protected:
+    void InitFromUnit(XLIFFStreamReader::Unit&& u);
+
     pugi::xml_node m_node;
     XLIFFStringMetadata m_metadata;
 };
@@ -102,7 +203,12 @@ public:
     ValidationResults Validate(bool wasJustLoaded) override;
 
     Language GetLanguage() const override { return m_language; }
-    void SetLanguage(Language lang) override { m_language = lang; }
+    void SetLanguage(Language lang) override
+    {
+        m_language = lang;
+        for (auto& i: m_items)
+            i->InvalidateCachedWordCounts();
+    }
 
     // FIXME: PO specific
     bool HasDeletedItems() const override { return false;}
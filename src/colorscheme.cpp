@@ -185,6 +185,13 @@ wxColour ColorScheme::DoGet(Color color, Mode mode)
         case Color::SyntaxFormat:
             return mode == Dark ? sRGB(250, 165, 251) : sRGB(178, 52, 197);
 
+        // Text differences:
+
+        case Color::DiffInsertedBg:
+            return mode == Dark ? sRGB(36, 90, 52) : sRGB(204, 240, 210);
+        case Color::DiffDeletedBg:
+            return mode == Dark ? sRGB(110, 42, 44) : sRGB(255, 215, 213);
+
         // Attention bar:
 
 #ifdef __WXGTK__
@@ -72,6 +72,9 @@ enum class Color : size_t
     SyntaxMarkup,
     SyntaxFormat,
 
+    DiffInsertedBg,
+    DiffDeletedBg,
+
     AttentionWarningBackground,
     AttentionQuestionBackground,
     AttentionErrorBackground,
@@ -0,0 +1,229 @@
+/*
+ *  This file is part of Poedit (https://poedit.net)
+ *
+ *  Copyright (C) 2020 Vaclav Slavik
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "compression.h"
+
+#include <wx/filename.h>
+#include <wx/log.h>
+#include <wx/translation.h>
+
+#include <fstream>
+#include <vector>
+
+
+namespace
+{
+
+const size_t STREAM_CHUNK_SIZE = 256 * 1024;
+
+class GzipInputStream : public std::istream
+{
+public:
+    explicit GzipInputStream(const wxString& filename)
+        : std::istream(nullptr),
+          m_file(filename),
+          m_zlib(m_file, wxZLIB_GZIP),
+          m_buffer(m_zlib)
+    {
+        rdbuf(&m_buffer);
+        if (!m_file.IsOk())
+            setstate(std::ios::failbit);
+    }
+
+private:
+    wxFileInputStream m_file;
+    wxZlibInputStream m_zlib;
+    wxStdInputStreamBuffer m_buffer;
+};
+
+} // anonymous namespace
+
+
+bool IsGzipFileName(const wxString& filename)
+{
+    return filename.Lower().EndsWith(".gz");
+}
+
+
+wxString StripGzipExtension(const wxString& filename)
+{
+    return IsGzipFileName(filename) ? filename.substr(0, filename.length() - 3) : filename;
+}
+
+
+bool GzipCompressFile(const wxString& src, const wxString& dest)
+{
+    wxFileInputStream in(src);
+    if (!in.IsOk())
+        return false;
+
+    wxFileOutputStream out(dest);
+    if (!out.IsOk())
+        return false;
+
+    {
+        wxZlibOutputStream zout(out, wxZ_DEFAULT_COMPRESSION, wxZLIB_GZIP);
+        std::unique_ptr<char[]> buffer(new char[STREAM_CHUNK_SIZE]);
+        while (!in.Eof())
+        {
+            const size_t len = in.Read(buffer.get(), STREAM_CHUNK_SIZE).LastRead();
+            if (in.GetLastError() != wxSTREAM_NO_ERROR && in.GetLastError() != wxSTREAM_EOF)
+                return false;
+            if (len && !zout.WriteAll(buffer.get(), len))
+                return false;
+        }
+        if (!zout.Close())
+            return false;
+    }
+
+    return out.Close();
+}
+
+
+std::unique_ptr<std::istream> OpenInputStream(const wxString& filename)
+{
+    if (IsGzipFileName(filename))
+        return std::unique_ptr<std::istream>(new GzipInputStream(filename));
+    else
+        return std::unique_ptr<std::istream>(new std::ifstream(filename.fn_str(), std::ios::in | std::ios::binary));
+}
+
+
+GzipOutputStream::GzipOutputStream(const wxString& filename)
+    : std::ostream(nullptr),
+      m_file(filename),
+      m_zlib(m_file, wxZ_DEFAULT_COMPRESSION, wxZLIB_GZIP),
+      m_buffer(m_zlib)
+{
+    rdbuf(&m_buffer);
+    if (!m_file.IsOk())
+        setstate(std::ios::failbit);
+}
+
+
+bool GzipOutputStream::Close()
+{
+    flush();
+    const bool ok = good();
+    // closing zlib stream writes the remaining data and gzip trailer:
+    return m_zlib.Close() && m_file.Close() && ok;
+}
+
+
+bool GzipTextFile::OnOpen(const wxString& strBufferName, wxTextBufferOpenMode openMode)
+{
+    m_compressed = IsGzipFileName(strBufferName);
+    if (!m_compressed)
+        return wxTextFile::OnOpen(strBufferName, openMode);
+
+    if (openMode != ReadAccess || !wxFileName::IsFileReadable(strBufferName))
+    {
+        wxLogError(_(L"File “%s” couldn’t be opened."), strBufferName);
+        return false;
+    }
+    return true;
+}
+
+
+bool GzipTextFile::OnClose()
+{
+    if (!m_compressed)
+        return wxTextFile::OnClose();
+    return true;
+}
+
+
+bool GzipTextFile::OnRead(const wxMBConv& conv)
+{
+    if (!m_compressed)
+        return wxTextFile::OnRead(conv);
+
+    // Decompress everything first, as wxTextFile reads the whole file too,
+    // because the charset conversion can't be done on arbitrary chunks:
+    std::vector<char> data;
+    {
+        wxFileInputStream file(GetName());
+        if (!file.IsOk())
+            return false;
+        wxZlibInputStream in(file, wxZLIB_GZIP);
+
+        size_t pos = 0;
+        for (;;)
+        {
+            data.resize(pos + STREAM_CHUNK_SIZE);
+            const size_t len = in.Read(data.data() + pos, STREAM_CHUNK_SIZE).LastRead();
+            pos += len;
+            if (in.GetLastError() == wxSTREAM_EOF)
+                break;
+            if (in.GetLastError() != wxSTREAM_NO_ERROR)
+            {
+                wxLogError(_(L"File “%s” is not a valid gzip file."), GetName());
+                return false;
+            }
+        }
+        data.resize(pos);
+    }
+
+    if (data.empty())
+        return true;
+
+    const wxString str(data.data(), conv, data.size());
+    data = std::vector<char>();
+    if (str.empty())
+    {
+        wxLogError(_(L"File “%s” couldn’t be read, its encoding is invalid."), GetName());
+        return false;
+    }
+
+    // split into lines the same way wxTextFile does:
+    auto lineStart = str.begin();
+    for (auto p = str.begin(); p != str.end(); ++p)
+    {
+        const wxChar ch = *p;
+        if (ch == '\n')
+        {
+            AddLine(wxString(lineStart, p), wxTextFileType_Unix);
+            lineStart = p + 1;
+        }
+        else if (ch == '\r')
+        {
+            auto next = p + 1;
+            if (next != str.end() && *next == '\n')
+            {
+                AddLine(wxString(lineStart, p), wxTextFileType_Dos);
+                p = next;
+            }
+            else
+            {
+                AddLine(wxString(lineStart, p), wxTextFileType_Mac);
+            }
+            lineStart = p + 1;
+        }
+    }
+    if (lineStart != str.end())
+        AddLine(wxString(lineStart, str.end()), wxTextFileType_None);
+
+    return true;
+}
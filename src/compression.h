@@ -0,0 +1,102 @@
+/*
+ *  This file is part of Poedit (https://poedit.net)
+ *
+ *  Copyright (C) 2020 Vaclav Slavik
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef Poedit_compression_h
+#define Poedit_compression_h
+
+#include <wx/stdstream.h>
+#include <wx/string.h>
+#include <wx/textfile.h>
+#include <wx/wfstream.h>
+#include <wx/zstream.h>
+
+#include <istream>
+#include <memory>
+#include <ostream>
+
+
+/// Returns true if the file name indicates gzip-compressed content (.gz)
+bool IsGzipFileName(const wxString& filename);
+
+/// Returns the file name without .gz extension, e.g. for type detection
+wxString StripGzipExtension(const wxString& filename);
+
+/**
+    Compresses file @a src into gzip file @a dest.
+
+    The data are streamed through zlib, the file isn't loaded into memory.
+ */
+bool GzipCompressFile(const wxString& src, const wxString& dest);
+
+/**
+    Opens file for reading as std::istream.
+
+    If the file is gzip-compressed (see IsGzipFileName()), it is decompressed
+    on the fly as it's being read.
+ */
+std::unique_ptr<std::istream> OpenInputStream(const wxString& filename);
+
+
+/// std::ostream writing gzip-compressed file, compressing the data on the fly
+class GzipOutputStream : public std::ostream
+{
+public:
+    explicit GzipOutputStream(const wxString& filename);
+
+    /// Finishes writing the file; returns false if anything failed
+    bool Close();
+
+private:
+    wxFileOutputStream m_file;
+    wxZlibOutputStream m_zlib;
+    wxStdOutputStreamBuffer m_buffer;
+};
+
+
+/**
+    wxTextFile that reads gzip-compressed files transparently.
+
+    Files are treated as compressed if they have .gz extension, others are
+    read as usual. Only reading is supported for compressed files; write them
+    uncompressed and use GzipCompressFile().
+
+    Note that, as with any wxTextFile, the whole (decompressed) content is
+    held in memory, so unlike XLIFF, PO files aren't loaded in a streaming way.
+ */
+class GzipTextFile : public wxTextFile
+{
+public:
+    GzipTextFile() : m_compressed(false) {}
+
+protected:
+    bool OnOpen(const wxString& strBufferName, wxTextBufferOpenMode openMode) override;
+    bool OnClose() override;
+    bool OnRead(const wxMBConv& conv) override;
+
+private:
+    bool m_compressed;
+};
+
+#endif // Poedit_compression_h
@@ -57,6 +57,22 @@ public:
     static bool UseTM() { return Read("/use_tm", true); }
     static void UseTM(bool use) { Write("/use_tm", use); }
 
+    // Whether to store and look up sentences of longer texts in the TM individually
+    static bool TMSentenceSegments() { return Read("/tm_sentence_segments", true); }
+    static void TMSentenceSegments(bool use) { Write("/tm_sentence_segments", use); }
+
+    // TM retention policy (0 means no limit), see TranslationMemory::Prune()
+    static long TMMaxAgeDays() { return Read("/tm_max_age_days", 0L); }
+    static void TMMaxAgeDays(long days) { Write("/tm_max_age_days", days); }
+    static long TMMaxEntriesPerLanguage() { return Read("/tm_max_entries_per_language", 0L); }
+    static void TMMaxEntriesPerLanguage(long count) { Write("/tm_max_entries_per_language", count); }
+    static bool TMRemoveUnused() { return Read("/tm_remove_unused", false); }
+    static void TMRemoveUnused(bool remove) { Write("/tm_remove_unused", remove); }
+
+    // When was the TM last pruned, as time_t
+    static long TMLastPruned() { return Read("/tm_last_pruned", 0L); }
+    static void TMLastPruned(long when) { Write("/tm_last_pruned", when); }
+
     static ::PretranslateSettings PretranslateSettings();
     static void PretranslateSettings(::PretranslateSettings s);
 
@@ -81,10 +97,12 @@ private:
     static bool Read(const std::string& key, std::string *out);
     static bool Read(const std::string& key, std::wstring *out);
     static bool Read(const std::string& key, bool *out);
+    static bool Read(const std::string& key, long *out);
 
     static void Write(const std::string& key, const std::string& value);
     static void Write(const std::string& key, const std::wstring& value);
     static void Write(const std::string& key, bool value);
+    static void Write(const std::string& key, long value);
 };
 
 #endif // Poedit_configuration_h
@@ -29,11 +29,16 @@
 #include "http_client.h"
 #include "keychain/keytar.h"
 #include "str_helpers.h"
+#include "utility.h"
 
+#include <fstream>
 #include <functional>
 #include <mutex>
 #include <boost/algorithm/string.hpp>
 
+#include <wx/dir.h>
+#include <wx/filename.h>
+#include <wx/log.h>
 #include <wx/translation.h>
 #include <wx/utils.h>
 
@@ -79,6 +84,127 @@ void ExtractFilesFromInfo(std::vector<std::wstring>& out, const json& r, const s
     }
 }
 
+
+// On-disk cache of metadata API responses, so that the UI can show last known
+// data immediately and only revalidate them with the server.
+
+#define METADATA_CACHE_PREFIX "metadata_"
+
+wxString GetMetadataCacheFile(const std::string& url)
+{
+    // FNV-1a, because the name must be stable across sessions
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c: url)
+    {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return wxString::Format("%s%c" METADATA_CACHE_PREFIX "%016llx.json",
+                            GetCacheDir("Crowdin"), wxFILE_SEP_PATH, (unsigned long long)hash);
+}
+
+struct CachedResponse
+{
+    std::string etag, last_modified;
+    json data;
+};
+
+bool LoadCachedResponse(const std::string& url, CachedResponse& out)
+{
+    auto filename = GetMetadataCacheFile(url);
+    if (!wxFileName::FileExists(filename))
+        return false;
+
+    try
+    {
+        std::ifstream f(filename.fn_str());
+        if (!f)
+            return false;
+        json j = json::parse(f);
+        out.etag = j["etag"];
+        out.last_modified = j["last_modified"];
+        out.data = j["data"];
+        return !out.data.is_null();
+    }
+    catch (...)
+    {
+        return false;  // corrupted cache is as good as none
+    }
+}
+
+void SaveCachedResponse(const std::string& url, const CachedResponse& r)
+{
+    json j;
+    j["etag"] = r.etag;
+    j["last_modified"] = r.last_modified;
+    j["data"] = r.data;
+
+    wxLogNull null;  // failure to write the cache isn't a problem for the user
+    TempOutputFileFor tempfile(GetMetadataCacheFile(url));
+    {
+        std::ofstream f(tempfile.FileName().fn_str());
+        f << j.dump();
+        if (!f)
+            return;
+    }
+    tempfile.Commit();
+}
+
+void ClearMetadataCache()
+{
+    wxLogNull null;
+    wxArrayString files;
+    wxDir::GetAllFiles(GetCacheDir("Crowdin"), &files, METADATA_CACHE_PREFIX "*.json", wxDIR_FILES);
+    for (auto& f: files)
+        wxRemoveFile(f);
+}
+
+#define USER_INFO_URL       "/api/account/profile?json="
+#define USER_PROJECTS_URL   "/api/account/get-projects?json=&role=all"
+
+std::string ProjectInfoURL(const std::string& project_id)
+{
+    return "/api/project/" + project_id + "/info?json=&project-identifier=" + project_id;
+}
+
+CrowdinClient::UserInfo ParseUserInfo(const json& r)
+{
+    json profile = r["profile"];
+    CrowdinClient::UserInfo u;
+    u.login = str::to_wstring(profile["login"]);
+    u.name = !profile["name"].is_null() ? str::to_wstring(profile["name"]) : u.login;
+    return u;
+}
+
+std::vector<CrowdinClient::ProjectListing> ParseUserProjects(const json& r)
+{
+    std::vector<CrowdinClient::ProjectListing> all;
+    for (auto i : r["projects"])
+    {
+        all.push_back({
+            str::to_wstring(i["name"]),
+            i["identifier"],
+            (bool)i["downloadable"].get<int>()
+        });
+    }
+    return all;
+}
+
+CrowdinClient::ProjectInfo ParseProjectInfo(const json& r)
+{
+    CrowdinClient::ProjectInfo prj;
+    auto details = r["details"];
+    prj.name = str::to_wstring(details["name"]);
+    prj.identifier = details["identifier"];
+    for (auto i : r["languages"])
+    {
+        if (i["can_translate"].get<int>() != 0)
+            prj.languages.push_back(Language::TryParse(str::to_wstring(i["code"])));
+    }
+    ExtractFilesFromInfo(prj.files, r, L"/");
+    return prj;
+}
+
 } // anonymous namespace
 
 
@@ -164,56 +290,93 @@ bool CrowdinClient::IsOAuthCallback(const std::string& uri)
 }
 
 
-dispatch::future<CrowdinClient::UserInfo> CrowdinClient::GetUserInfo()
+dispatch::future<json> CrowdinClient::GetWithCache(const std::string& url)
 {
-    return m_api->get("/api/account/profile?json=")
-        .then([](json r)
+    auto cached = std::make_shared<CachedResponse>();
+    if (!LoadCachedResponse(url, *cached))
+        *cached = CachedResponse();
+
+    return m_api->get_conditional(url, cached->etag, cached->last_modified)
+        .then([=](http_client::conditional_response r)
         {
-            json profile = r["profile"];
-            UserInfo u;
-            u.login = str::to_wstring(profile["login"]);
-            u.name = !profile["name"].is_null() ? str::to_wstring(profile["name"]) : u.login;
-            return u;
+            if (r.not_modified)
+                return cached->data;
+
+            SaveCachedResponse(url, {r.etag, r.last_modified, r.data});
+            return r.data;
         });
 }
 
 
+dispatch::future<CrowdinClient::UserInfo> CrowdinClient::GetUserInfo()
+{
+    return GetWithCache(USER_INFO_URL)
+        .then([](json r){ return ParseUserInfo(r); });
+}
+
+
+bool CrowdinClient::GetCachedUserInfo(UserInfo& out) const
+{
+    CachedResponse cached;
+    if (!LoadCachedResponse(USER_INFO_URL, cached))
+        return false;
+    try
+    {
+        out = ParseUserInfo(cached.data);
+        return true;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+
 dispatch::future<std::vector<CrowdinClient::ProjectListing>> CrowdinClient::GetUserProjects()
 {
-    return m_api->get("/api/account/get-projects?json=&role=all")
-        .then([](json r)
-        {
-            std::vector<ProjectListing> all;
-            for (auto i : r["projects"])
-            {
-                all.push_back({
-                    str::to_wstring(i["name"]),
-                    i["identifier"],
-                    (bool)i["downloadable"].get<int>()
-                });
-            }
-            return all;
-        });
+    return GetWithCache(USER_PROJECTS_URL)
+        .then([](json r){ return ParseUserProjects(r); });
+}
+
+
+bool CrowdinClient::GetCachedUserProjects(std::vector<ProjectListing>& out) const
+{
+    CachedResponse cached;
+    if (!LoadCachedResponse(USER_PROJECTS_URL, cached))
+        return false;
+    try
+    {
+        out = ParseUserProjects(cached.data);
+        return true;
+    }
+    catch (...)
+    {
+        return false;
+    }
 }
 
 
 dispatch::future<CrowdinClient::ProjectInfo> CrowdinClient::GetProjectInfo(const std::string& project_id)
 {
-    auto url = "/api/project/" + project_id + "/info?json=&project-identifier=" + project_id;
-    return m_api->get(url)
-        .then([](json r){
-            ProjectInfo prj;
-            auto details = r["details"];
-            prj.name = str::to_wstring(details["name"]);
-            prj.identifier = details["identifier"];
-            for (auto i : r["languages"])
-            {
-                if (i["can_translate"].get<int>() != 0)
-                    prj.languages.push_back(Language::TryParse(str::to_wstring(i["code"])));
-            }
-            ExtractFilesFromInfo(prj.files, r, L"/");
-            return prj;
-        });
+    return GetWithCache(ProjectInfoURL(project_id))
+        .then([](json r){ return ParseProjectInfo(r); });
+}
+
+
+bool CrowdinClient::GetCachedProjectInfo(const std::string& project_id, ProjectInfo& out) const
+{
+    CachedResponse cached;
+    if (!LoadCachedResponse(ProjectInfoURL(project_id), cached))
+        return false;
+    try
+    {
+        out = ParseProjectInfo(cached.data);
+        return true;
+    }
+    catch (...)
+    {
+        return false;
+    }
 }
 
 
@@ -274,6 +437,7 @@ void CrowdinClient::SetToken(const std::string& token)
 
 void CrowdinClient::SaveAndSetToken(const std::string& token)
 {
+    ClearMetadataCache();  // may be a different account
     SetToken(token);
     keytar::AddPassword("Crowdin", "", token);
 }
@@ -283,6 +447,7 @@ void CrowdinClient::SignOut()
 {
     m_api->set_authorization("");
     keytar::DeletePassword("Crowdin", "");
+    ClearMetadataCache();
 }
 
 
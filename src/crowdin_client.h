@@ -31,6 +31,7 @@
 #include <memory>
 
 #include "concurrency.h"
+#include "json.h"
 #include "language.h"
 
 
@@ -76,17 +77,36 @@ public:
     /// Retrieve information about the current user asynchronously
     dispatch::future<UserInfo> GetUserInfo();
 
+    /**
+        Last known information about the current user, from on-disk cache.
+
+        Returns immediately without contacting the server, so that the UI can
+        be populated while GetUserInfo() revalidates the data. The same is
+        true of GetCachedUserProjects() and GetCachedProjectInfo().
+
+        @return false if nothing is cached.
+     */
+    bool GetCachedUserInfo(UserInfo& out) const;
+
     /// Project listing info
     struct ProjectListing
     {
         std::wstring name;
         std::string identifier;
         bool downloadable;
+
+        bool operator==(const ProjectListing& other) const
+        {
+            return name == other.name && identifier == other.identifier && downloadable == other.downloadable;
+        }
     };
 
     /// Retrieve listing of projects accessible to the user
     dispatch::future<std::vector<ProjectListing>> GetUserProjects();
 
+    /// Last known listing of projects, see GetCachedUserInfo()
+    bool GetCachedUserProjects(std::vector<ProjectListing>& out) const;
+
     /// Project detailed information
     struct ProjectInfo
     {
@@ -94,11 +114,20 @@ public:
         std::string identifier;
         std::vector<Language> languages;
         std::vector<std::wstring> files;
+
+        bool operator==(const ProjectInfo& other) const
+        {
+            return name == other.name && identifier == other.identifier &&
+                   languages == other.languages && files == other.files;
+        }
     };
 
     /// Retrieve listing of projects accessible to the user
     dispatch::future<ProjectInfo> GetProjectInfo(const std::string& project_id);
 
+    /// Last known project information, see GetCachedUserInfo()
+    bool GetCachedProjectInfo(const std::string& project_id, ProjectInfo& out) const;
+
     /// Asynchronously download specific Crowdin file into @a output_file.
     dispatch::future<void> DownloadFile(const std::string& project_id,
                                         const std::wstring& file,
@@ -119,6 +148,10 @@ private:
     void SetToken(const std::string& token);
     void SaveAndSetToken(const std::string& token);
 
+    // GET request that keeps the response in on-disk cache and revalidates
+    // it with the server using ETag / Last-Modified
+    dispatch::future<json> GetWithCache(const std::string& url);
+
     class crowdin_http_client;
     std::unique_ptr<crowdin_http_client> m_api;
 
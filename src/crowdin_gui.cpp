@@ -55,6 +55,8 @@
     #define CenterVertical() Center()
 #endif
 
+#include <algorithm>
+
 #include <boost/algorithm/string.hpp>
 
 CrowdinLoginPanel::CrowdinLoginPanel(wxWindow *parent, int flags)
@@ -192,10 +194,23 @@ void CrowdinLoginPanel::CreateLoginInfoControls(State state)
 
 void CrowdinLoginPanel::UpdateUserInfo()
 {
-    ChangeState(State::UpdatingInfo);
+    // Show last known user immediately and only refresh it from the server:
+    CrowdinClient::UserInfo cached;
+    if (CrowdinClient::Get().GetCachedUserInfo(cached))
+    {
+        m_userName = cached.name;
+        m_userLogin = cached.login;
+        ChangeState(State::SignedIn);
+    }
+    else
+    {
+        ChangeState(State::UpdatingInfo);
+    }
 
     CrowdinClient::Get().GetUserInfo()
         .then_on_window(this, [=](CrowdinClient::UserInfo u) {
+            if (m_state == State::SignedIn && m_userName == u.name && m_userLogin == u.login)
+                return;  // cached data were up to date
             m_userName = u.name;
             m_userLogin = u.login;
             ChangeState(State::SignedIn);
@@ -342,7 +357,14 @@ private:
 
     void FetchProjects()
     {
-        m_activity->Start();
+        // Populate the dialog from cache right away, if possible, and refresh
+        // it quietly when the server responds:
+        std::vector<CrowdinClient::ProjectListing> cached;
+        if (CrowdinClient::Get().GetCachedUserProjects(cached))
+            OnFetchedProjects(cached);
+        else
+            m_activity->Start();
+
         CrowdinClient::Get().GetUserProjects()
             .then_on_window(this, &CrowdinOpenDialog::OnFetchedProjects)
             .catch_all(m_activity->HandleError);
@@ -350,12 +372,42 @@ private:
 
     void OnFetchedProjects(std::vector<CrowdinClient::ProjectListing> prjs)
     {
+        if (m_projectsLoaded && prjs == m_projects)
+            return;  // cached data were up to date
+
+        std::string selected;
+        if (m_project->GetSelection() > 0)
+            selected = m_projects[m_project->GetSelection() - 1].identifier;
+
         m_projects = prjs;
+        m_projectsLoaded = true;
+        m_project->Clear();
         m_project->Append("");
         for (auto& p: prjs)
             m_project->Append(p.name);
         m_project->Enable(!prjs.empty());
 
+        if (!selected.empty())
+        {
+            for (size_t i = 0; i < prjs.size(); i++)
+            {
+                if (prjs[i].identifier == selected)
+                {
+                    // keep the user's choice, its details are loaded already
+                    m_project->SetSelection(1 + int(i));
+                    return;
+                }
+            }
+
+            // previously selected project is gone:
+            m_info = CrowdinClient::ProjectInfo();
+            m_supportedFilesCount = 0;
+            m_language->Clear();
+            m_file->Clear();
+            m_language->Disable();
+            m_file->Disable();
+        }
+
         if (prjs.empty())
             m_activity->StopWithError(_("No translation projects listed in your Crowdin account."));
         else
@@ -373,34 +425,66 @@ private:
         auto sel = m_project->GetSelection();
         if (sel > 0)
         {
-            m_activity->Start();
-            EnableAllChoices(false);
-            CrowdinClient::Get().GetProjectInfo(m_projects[sel-1].identifier)
-                .then_on_window(this, &CrowdinOpenDialog::OnFetchedProjectInfo)
+            auto project_id = m_projects[sel-1].identifier;
+
+            CrowdinClient::ProjectInfo cached;
+            if (CrowdinClient::Get().GetCachedProjectInfo(project_id, cached))
+            {
+                OnFetchedProjectInfo(project_id, cached);
+            }
+            else
+            {
+                m_activity->Start();
+                EnableAllChoices(false);
+            }
+
+            CrowdinClient::Get().GetProjectInfo(project_id)
+                .then_on_window(this, [=](CrowdinClient::ProjectInfo prj){ OnFetchedProjectInfo(project_id, prj); })
                 .catch_all(m_activity->HandleError);
         }
     }
 
-    void OnFetchedProjectInfo(CrowdinClient::ProjectInfo prj)
+    void OnFetchedProjectInfo(const std::string& project_id, CrowdinClient::ProjectInfo prj)
     {
-        m_info = prj;
+        auto sel = m_project->GetSelection();
+        if (sel <= 0 || m_projects[sel-1].identifier != project_id)
+            return;  // response to an outdated request, another project was selected since
+
         // Put supported files first in the list:
+        CrowdinClient::ProjectInfo info(prj);
         std::vector<std::wstring> f_unsup;
-        m_info.files.clear();
-        m_supportedFilesCount = 0;
+        info.files.clear();
+        int supportedFilesCount = 0;
         for (auto& i: prj.files)
         {
             if (IsFileSupported(i))
             {
-                m_info.files.push_back(i);
-                m_supportedFilesCount++;
+                info.files.push_back(i);
+                supportedFilesCount++;
             }
             else
             {
                 f_unsup.push_back(i);
             }
         }
-        std::move(f_unsup.begin(), f_unsup.end(), std::inserter(m_info.files, m_info.files.end()));
+        std::move(f_unsup.begin(), f_unsup.end(), std::inserter(info.files, info.files.end()));
+
+        if (info == m_info && !m_activity->IsRunning())
+            return;  // cached data were up to date
+
+        // Preserve user's choices when refreshing the same project:
+        Language prevLang;
+        std::wstring prevFile;
+        if (info.identifier == m_info.identifier)
+        {
+            if (m_language->GetSelection() > 0)
+                prevLang = m_info.languages[m_language->GetSelection() - 1];
+            if (m_file->GetSelection() > 0)
+                prevFile = m_info.files[m_file->GetSelection() - 1];
+        }
+
+        m_info = info;
+        m_supportedFilesCount = supportedFilesCount;
 
         m_language->Clear();
         m_language->Append("");
@@ -425,7 +509,14 @@ private:
         EnableAllChoices();
         m_activity->Stop();
 
-        if (m_info.languages.size() == 1)
+        auto prevLangIter = std::find(m_info.languages.begin(), m_info.languages.end(), prevLang);
+        auto prevFileIter = std::find(m_info.files.begin(), m_info.files.end(), prevFile);
+
+        if (prevLang.IsValid() && prevLangIter != m_info.languages.end())
+        {
+            m_language->SetSelection(1 + int(prevLangIter - m_info.languages.begin()));
+        }
+        else if (m_info.languages.size() == 1)
         {
             m_language->SetSelection(1);
         }
@@ -445,7 +536,9 @@ private:
             }
         }
 
-        if (m_supportedFilesCount == 1)
+        if (!prevFile.empty() && prevFileIter != m_info.files.end())
+            m_file->SetSelection(1 + int(prevFileIter - m_info.files.begin()));
+        else if (m_supportedFilesCount == 1)
             m_file->SetSelection(1);
 
         if (m_supportedFilesCount == 0)
@@ -503,23 +596,7 @@ private:
 
     wxString CreateLocalFilename(const wxString& name, const Language& lang)
     {
-        wxString cache;
-    #if defined(__WXOSX__)
-        cache = wxGetHomeDir() + "/Library/Caches/net.poedit.Poedit";
-    #elif defined(__UNIX__)
-        if (!wxGetEnv("XDG_CACHE_HOME", &cache))
-            cache = wxGetHomeDir() + "/.cache";
-        cache += "/poedit";
-    #else
-        cache = wxStandardPaths::Get().GetUserDataDir() + wxFILE_SEP_PATH + "Cache";
-    #endif
-
-        cache += wxFILE_SEP_PATH;
-        cache += "Crowdin";
-
-        if (!wxFileName::DirExists(cache))
-            wxFileName::Mkdir(cache, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
-
+        auto cache = GetCacheDir("Crowdin");
         auto basename = name.AfterLast('/').BeforeLast('.');
 
         return wxString::Format("%s%c%s_%s_%s.po", cache, wxFILE_SEP_PATH, m_info.name, basename, lang.Code());
@@ -531,8 +608,9 @@ private:
     ActivityIndicator *m_activity;
 
     std::vector<CrowdinClient::ProjectListing> m_projects;
+    bool m_projectsLoaded = false;
     CrowdinClient::ProjectInfo m_info;
-    int m_supportedFilesCount;
+    int m_supportedFilesCount = 0;
 };
 
 } // anonymous namespace
@@ -197,20 +197,110 @@ void AutoWrappingText::SetAlignment(TextDirection dir)
 }
 
 void AutoWrappingText::SetAndWrapLabel(const wxString& label)
+{
+    SetAndWrapLabel(label, std::vector<Highlight>());
+}
+
+void AutoWrappingText::SetAndWrapLabel(const wxString& label, const std::vector<Highlight>& highlights)
 {
     m_text = bidi::platform_mark_direction(label);
+    m_highlightedLabel = highlights.empty() ? wxString() : label;
+    m_highlights = highlights;
     if (!m_language.IsValid())
         SetAlignment(bidi::get_base_direction(m_text));
 
     wxWindowUpdateLocker lock(this);
     m_wrapWidth = GetSize().x;
-    SetLabelText(WrapTextAtWidth(label, m_wrapWidth, m_language, this));
+    SetWrappedLabel(WrapTextAtWidth(label, m_wrapWidth, m_language, this), /*asText=*/true);
 
     InvalidateBestSize();
     SetMinSize(wxDefaultSize);
     SetMinSize(GetBestSize());
 }
 
+void AutoWrappingText::SetWrappedLabel(const wxString& wrapped, bool asText)
+{
+#if wxCHECK_VERSION(3,1,1)
+    if (!m_highlights.empty())
+    {
+        SetLabelMarkup(MarkupHighlights(wrapped));
+        return;
+    }
+#endif
+
+    if (asText)
+        SetLabelText(wrapped);
+    else
+        SetLabel(wrapped);
+}
+
+wxString AutoWrappingText::MarkupHighlights(const wxString& wrapped) const
+{
+    auto spanFor = [=](Highlight::Style style)
+    {
+        auto bg = ColorScheme::Get(style == Highlight::Style::Inserted ? Color::DiffInsertedBg : Color::DiffDeletedBg, const_cast<AutoWrappingText*>(this));
+        wxString span = "<span bgcolor=\"" + bg.GetAsString(wxC2S_HTML_SYNTAX) + "\">";
+        if (style == Highlight::Style::Deleted)
+            span += "<s>";
+        return span;
+    };
+    auto spanEnd = [](Highlight::Style style)
+    {
+        return wxString(style == Highlight::Style::Deleted ? "</s></span>" : "</span>");
+    };
+
+    // Wrapping only inserts characters (line breaks, direction marks) into
+    // the label, so the two can be walked in parallel to apply highlights:
+    const wxString& label = m_highlightedLabel;
+    wxString out;
+    out.reserve(wrapped.length() + 64 * m_highlights.size());
+
+    size_t pos = 0;
+    auto hl = m_highlights.begin();
+    const Highlight *open = nullptr;
+
+    for (size_t i = 0; i < wrapped.length(); i++)
+    {
+        const wxUniChar c = wrapped[i];
+        if (pos < label.length() && c == label[pos])
+        {
+            while (hl != m_highlights.end() && hl->start + hl->length <= pos)
+                ++hl;
+            const Highlight *current = (hl != m_highlights.end() && hl->start <= pos) ? &*hl : nullptr;
+            if (current != open)
+            {
+                if (open)
+                    out += spanEnd(open->style);
+                if (current)
+                    out += spanFor(current->style);
+                open = current;
+            }
+            pos++;
+        }
+        else if (c == '\n' && open)
+        {
+            // don't highlight line ends, it looks odd
+            out += spanEnd(open->style);
+            open = nullptr;
+        }
+
+        switch (c.GetValue())
+        {
+            case '&':  out += "&amp;";  break;
+            case '<':  out += "&lt;";   break;
+            case '>':  out += "&gt;";   break;
+            case '"':  out += "&quot;"; break;
+            case '\'': out += "&apos;"; break;
+            default:   out += c;        break;
+        }
+    }
+
+    if (open)
+        out += spanEnd(open->style);
+
+    return out;
+}
+
 void AutoWrappingText::OnSize(wxSizeEvent& e)
 {
     e.Skip();
@@ -225,7 +315,7 @@ void AutoWrappingText::OnSize(wxSizeEvent& e)
     wxWindowUpdateLocker lock(this);
 
     m_wrapWidth = w;
-    SetLabel(WrapTextAtWidth(m_text, w, m_language, this));
+    SetWrappedLabel(WrapTextAtWidth(m_text, w, m_language, this), /*asText=*/false);
 
     InvalidateBestSize();
     SetMinSize(wxDefaultSize);
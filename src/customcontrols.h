@@ -39,6 +39,7 @@ class WXDLLIMPEXP_ADV wxActivityIndicator;
 
 #include <exception>
 #include <functional>
+#include <vector>
 
 
 // Label marking a subsection of a dialog:
@@ -59,12 +60,41 @@ public:
 
     void SetAndWrapLabel(const wxString& label);
 
+    /// Highlighted part of the label, see SetAndWrapLabel()
+    struct Highlight
+    {
+        enum class Style
+        {
+            Inserted,
+            Deleted
+        };
+
+        size_t start, length;
+        Style style;
+    };
+
+    /**
+        Sets label with some parts of it visually highlighted.
+
+        @a highlights must be sorted and non-overlapping. Highlighting
+        requires markup support in wxStaticText, the text is shown
+        plain if it's not available.
+     */
+    void SetAndWrapLabel(const wxString& label, const std::vector<Highlight>& highlights);
+
 protected:
     void OnSize(wxSizeEvent& e);
 
+    // Sets already wrapped text, applying highlights if there are any
+    void SetWrappedLabel(const wxString& wrapped, bool asText);
+    wxString MarkupHighlights(const wxString& wrapped) const;
+
     wxString m_text;
     int m_wrapWidth;
     Language m_language;
+
+    wxString m_highlightedLabel;
+    std::vector<Highlight> m_highlights;
 };
 
 /// Like AutoWrappingText, but allows selecting (macOS) or at least copying (Windows)
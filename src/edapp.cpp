@@ -83,6 +83,7 @@
 #include "icons.h"
 #include "version.h"
 #include "str_helpers.h"
+#include "tm/retention.h"
 #include "tm/transmem.h"
 #include "utility.h"
 #include "prefsdlg.h"
@@ -508,6 +509,9 @@ bool PoeditApp::OnInit()
     win_sparkle_init();
 #endif
 
+    // apply the TM retention policy, if the user configured one:
+    TMRetention::PruneIfDue();
+
 #ifndef __WXOSX__
     // If we failed to open any window during startup (e.g. because the user
     // attempted to open MO files), shut the app down. Don't do this on macOS
@@ -72,10 +72,12 @@
 #include "prefsdlg.h"
 #include "fileviewer.h"
 #include "findframe.h"
+#include "goto_entry.h"
 #include "tm/transmem.h"
 #include "language.h"
 #include "progressinfo.h"
 #include "commentdlg.h"
+#include "compression.h"
 #include "main_toolbar.h"
 #include "manager.h"
 #include "pretranslate.h"
@@ -87,6 +89,7 @@
 #include "sidebar.h"
 #include "spellchecking.h"
 #include "str_helpers.h"
+#include "text_statistics.h"
 
 
 namespace
@@ -325,6 +328,7 @@ BEGIN_EVENT_TABLE(PoeditFrame, wxFrame)
    EVT_MENU           (wxID_REPLACE,              PoeditFrame::OnFindAndReplace)
    EVT_MENU           (XRCID("menu_find_next"),   PoeditFrame::OnFindNext)
    EVT_MENU           (XRCID("menu_find_prev"),   PoeditFrame::OnFindPrev)
+   EVT_MENU           (XRCID("go_to_entry"),      PoeditFrame::OnGoToEntry)
    EVT_MENU           (XRCID("menu_comment"),     PoeditFrame::OnEditComment)
    EVT_BUTTON         (XRCID("menu_comment"),     PoeditFrame::OnEditComment)
    EVT_MENU           (XRCID("go_done_and_next"),   PoeditFrame::OnDoneAndNext)
@@ -344,6 +348,7 @@ BEGIN_EVENT_TABLE(PoeditFrame, wxFrame)
    EVT_MENU_RANGE     (ID_BOOKMARK_SET, ID_BOOKMARK_SET + 9,
                        PoeditFrame::OnSetBookmark)
    EVT_CLOSE          (                PoeditFrame::OnCloseWindow)
+   EVT_ACTIVATE       (                PoeditFrame::OnActivate)
    EVT_SIZE           (PoeditFrame::OnSize)
 
    // handling of selection:
@@ -370,6 +375,7 @@ BEGIN_EVENT_TABLE(PoeditFrame, wxFrame)
    EVT_UPDATE_UI(wxID_SAVE,                   PoeditFrame::OnHasCatalogUpdate)
    EVT_UPDATE_UI(wxID_SAVEAS,                 PoeditFrame::OnHasCatalogUpdate)
    EVT_UPDATE_UI(XRCID("menu_statistics"),    PoeditFrame::OnHasCatalogUpdate)
+   EVT_UPDATE_UI(XRCID("go_to_entry"),        PoeditFrame::OnHasCatalogUpdate)
    EVT_UPDATE_UI(XRCID("menu_pretranslate"),  PoeditFrame::OnIsEditableUpdate)
    EVT_UPDATE_UI(XRCID("menu_validate"),      PoeditFrame::OnIsEditableUpdate)
    EVT_UPDATE_UI(XRCID("menu_update_from_src"), PoeditFrame::OnUpdateFromSourcesUpdate)
@@ -418,7 +424,7 @@ public:
         }
 
         wxFileName f(files[0]);
-        if (!Catalog::CanLoadFile(f.GetExt()))
+        if (!Catalog::CanLoadFile(wxFileName(StripGzipExtension(files[0])).GetExt()))
         {
             wxLogError(_(L"File “%s” is not a translation file."),
                        f.GetFullPath().c_str());
@@ -452,6 +458,7 @@ PoeditFrame::PoeditFrame() :
     m_contentView(nullptr),
     m_catalog(nullptr),
     m_fileExistsOnDisk(false),
+    m_fileSize(0),
     m_list(nullptr),
     m_modified(false),
     m_hasObsoleteItems(false),
@@ -496,7 +503,11 @@ PoeditFrame::PoeditFrame() :
         FileHistory().UseMenu(m_menuForHistory);
         FileHistory().AddFilesToMenu(m_menuForHistory);
 #endif
-        AddBookmarksMenu(MenuBar->GetMenu(MenuBar->FindMenu(_("&Go"))));
+        wxMenu *goMenu = MenuBar->GetMenu(MenuBar->FindMenu(_("&Go")));
+        goMenu->AppendSeparator();
+        goMenu->Append(XRCID("go_to_entry"),
+                       MSW_OR_OTHER(_(L"Go to entry…"), _(L"Go to Entry…")) + "\tCtrl+J");
+        AddBookmarksMenu(goMenu);
 #ifdef __WXOSX__
         wxGetApp().TweakOSXMenuBar(MenuBar);
 #endif
@@ -519,6 +530,14 @@ PoeditFrame::PoeditFrame() :
 
     m_toolbar = MainToolbar::Create(this);
 
+    // Commit deferred edits from the editing area before any command
+    // (including keyboard shortcuts) gets to act on the catalog:
+    Bind(wxEVT_MENU, [=](wxCommandEvent& e){
+        e.Skip();
+        if (m_editingArea)
+            m_editingArea->FlushPendingChanges();
+    });
+
     GetMenuBar()->Check(XRCID("menu_ids"), m_displayIDs);
     GetMenuBar()->Check(XRCID("menu_warnings"), Config::ShowWarnings());
 
@@ -745,6 +764,9 @@ void PoeditFrame::DestroyContentView()
     if (!m_contentView)
         return;
 
+    if (m_editingArea)
+        m_editingArea->FlushPendingChanges();
+
     NotifyCatalogChanged(nullptr);
 
     if (m_splitter)
@@ -765,6 +787,11 @@ void PoeditFrame::DestroyContentView()
         m_findWindow->Destroy();
         m_findWindow.Release();
     }
+    if (m_gotoEntryWindow)
+    {
+        m_gotoEntryWindow->Destroy();
+        m_gotoEntryWindow.Release();
+    }
 }
 
 
@@ -821,6 +848,20 @@ void PoeditFrame::PlaceInitialFocus(int lineno)
 }
 
 
+void PoeditFrame::FocusCatalogItem(int index)
+{
+    if (!m_list)
+        return;
+
+    // NB: must be called after the delayed PlaceInitialFocus() call, see Create()
+    m_list->CallAfter([=]{
+        if (!m_catalog || !m_list || index < 0 || index >= (int)m_catalog->GetCount())
+            return;
+        m_list->SelectAndFocus(m_list->CatalogIndexToList(index));
+    });
+}
+
+
 void PoeditFrame::SetAccelerators()
 {
     wxAcceleratorEntry entries[] = {
@@ -861,6 +902,11 @@ void PoeditFrame::InitSpellchecker()
     if (!m_catalog || !m_catalog->HasCapability(Catalog::Cap::Translations))
         return;
 
+    // this is called after loading a file or changing its language or the
+    // preferences, which is when the user may expect a newly installed
+    // dictionary to be used:
+    SpellcheckingService::Get().ForgetMissingDictionaries();
+
     Language lang = m_catalog->GetLanguage();
 
     bool report_problem = false;
@@ -1040,6 +1086,9 @@ wxWindowPtr<wxMessageDialog> PoeditFrame::CreateAskAboutSavingDialog()
 
 void PoeditFrame::OnCloseWindow(wxCloseEvent& event)
 {
+    if (m_editingArea)
+        m_editingArea->FlushPendingChanges();
+
     if (event.CanVeto() && NeedsToAskIfCanDiscardCurrentDoc())
     {
 #ifdef __WXOSX__
@@ -1931,6 +1980,9 @@ void PoeditFrame::OnListSel(wxDataViewEvent& event)
 
     event.Skip();
 
+    // commit edits of the previously selected item, if any
+    m_editingArea->FlushPendingChanges();
+
     if (m_pendingHumanEditedItem)
     {
         OnNewTranslationEntered(m_pendingHumanEditedItem);
@@ -2149,6 +2201,17 @@ void PoeditFrame::OnFindPrev(wxCommandEvent&)
         m_findWindow->FindPrev();
 }
 
+void PoeditFrame::OnGoToEntry(wxCommandEvent&)
+{
+    if (!m_catalog || !m_list)
+        return;
+
+    if (!m_gotoEntryWindow)
+        m_gotoEntryWindow = new GoToEntryDialog(this, m_catalog);
+
+    m_gotoEntryWindow->ShowPalette();
+}
+
 void PoeditFrame::OnUpdateFind(wxUpdateUIEvent& e)
 {
     e.Enable(m_catalog && !m_catalog->empty() &&
@@ -2190,24 +2253,12 @@ void PoeditFrame::OnNewTranslationEntered(const CatalogItemPtr& item)
 
     if (Config::UseTM())
     {
-        auto srclang = m_catalog->GetSourceLanguage();
-        auto lang = m_catalog->GetLanguage();
-        dispatch::async([=](){
-            try
-            {
-                auto tm = TranslationMemory::Get().GetWriter();
-                tm->Insert(srclang, lang, item);
-                // Note: do *not* call tm->Commit() here, because Lucene commit is
-                // expensive. Instead, wait until the file is saved with committing
-                // the changes. This way TM updates are available immediately for use
-                // in further translations within the file, but per-item updates
-                // remain inexpensive.
-            }
-            catch (const Exception&)
-            {
-                // ignore failures here, they'll become apparent when saving the file
-            }
-        });
+        // Note: this doesn't commit the change, because Lucene commit is
+        // expensive. Queued inserts are written in batches and committed
+        // only occasionally, the rest when the file is saved. This way TM
+        // updates are available immediately for use in further translations
+        // within the file, but per-item updates remain inexpensive.
+        TranslationMemory::Get().InsertAsync(m_catalog->GetSourceLanguage(), m_catalog->GetLanguage(), item);
     }
 }
 
@@ -2218,6 +2269,7 @@ void PoeditFrame::UpdateToTextCtrl(int flags)
     if (!item)
         return;
 
+    m_editingArea->FlushPendingChanges();
     m_pendingHumanEditedItem.reset();
 
     m_editingArea->UpdateToTextCtrl(item, flags);
@@ -2287,12 +2339,17 @@ void PoeditFrame::ReadCatalog(const CatalogPtr& cat)
 
         m_fileExistsOnDisk = true;
         m_modified = false;
+        NoteFileModificationTime();
 
         RecreatePluralTextCtrls();
         RefreshControls(Refresh_NoCatalogChanged /*done right above*/);
         UpdateTitle();
         UpdateTextLanguage();
 
+        // prepare the TM in the background, so that first suggestions come fast:
+        if (Config::UseTM() && cat->HasCapability(Catalog::Cap::Translations) && cat->GetLanguage().IsValid())
+            TranslationMemory::WarmUpAsync(cat);
+
         NoteAsRecentFile();
 
         if (cat->HasCapability(Catalog::Cap::Translations))
@@ -2470,6 +2527,178 @@ void PoeditFrame::NoteAsRecentFile()
 }
 
 
+void PoeditFrame::NoteFileModificationTime()
+{
+    wxLogNull null;
+    wxFileName fn(GetFileName());
+    if (m_fileExistsOnDisk && fn.FileExists())
+    {
+        m_fileModificationTime = fn.GetModificationTime();
+        m_fileSize = fn.GetSize();
+    }
+    else
+    {
+        m_fileModificationTime = wxDateTime();
+        m_fileSize = 0;
+    }
+}
+
+
+void PoeditFrame::OnActivate(wxActivateEvent& event)
+{
+    event.Skip();
+
+    // Build scripts or VCS operations may have rewritten the file while
+    // the user was elsewhere. Check after the activation is fully processed,
+    // because we may need to show a window-modal dialog:
+    if (event.GetActive())
+        CallAfter([=]{ CheckForExternalChanges(); });
+}
+
+
+void PoeditFrame::CheckForExternalChanges()
+{
+    if (!m_catalog || !m_fileExistsOnDisk || !m_fileModificationTime.IsValid())
+        return;
+
+    auto filename = GetFileName();
+    wxFileName fn(filename);
+    if (!fn.FileExists())
+        return;
+
+    // The size is compared too, because not all filesystems store the time
+    // with sub-second precision and a quick rewrite could go unnoticed:
+    wxDateTime modtime;
+    wxULongLong size;
+    {
+        wxLogNull null;
+        modtime = fn.GetModificationTime();
+        size = fn.GetSize();
+    }
+    if (!modtime.IsValid() || (modtime == m_fileModificationTime && size == m_fileSize))
+        return;
+
+    // don't ask about the same change again:
+    m_fileModificationTime = modtime;
+    m_fileSize = size;
+
+    if (!m_modified)
+    {
+        ReloadCatalogFromDisk();
+        return;
+    }
+
+    wxWindowPtr<wxMessageDialog> dlg(new wxMessageDialog
+                    (
+                        this,
+                        wxString::Format(_(L"The file “%s” was modified by another application."), wxFileName(filename).GetFullName()),
+                        _("File changed"),
+                        wxYES_NO | wxICON_QUESTION
+                    ));
+    dlg->SetExtendedMessage(_("Do you want to reload it? Your unsaved changes will be lost."));
+    dlg->SetYesNoLabels(_("Reload"), _("Keep Current Version"));
+
+    dlg->ShowWindowModalThenDo([this,dlg](int retval) {
+        if (retval == wxID_YES)
+            ReloadCatalogFromDisk();
+    });
+}
+
+
+void PoeditFrame::ReloadCatalogFromDisk()
+{
+    wxBusyCursor bcur;
+
+    CatalogPtr cat;
+    try
+    {
+        cat = Catalog::Create(GetFileName());
+    }
+    catch (...)
+    {
+        cat.reset();
+    }
+    // the file may be half-written at the moment, keep the current version
+    // then; the next change will trigger another reload:
+    if (!cat || !cat->IsOk())
+        return;
+
+    {
+        wxLogNull null;  // don't report non-item warnings
+        cat->Validate(/*wasJustLoaded:*/true);
+    }
+
+    Catalog::ReloadDiff diff;
+    if (!m_list || m_catalog->empty() || cat->empty() || !m_catalog->CompareWithReloaded(*cat, diff))
+    {
+        // The file changed too much to patch the UI, so do a full reload, but
+        // keep the user's place in the file, identified by (msgctxt, msgid):
+        auto keyOf = [](const CatalogItemPtr& item) -> wxString
+        {
+            return item->HasContext() ? item->GetContext() + wxS('\x04') + item->GetString() : item->GetString();
+        };
+        auto current = GetCurrentItem();
+        wxString currentKey = current ? keyOf(current) : wxString();
+
+        ReadCatalog(cat);
+
+        if (m_list && !currentKey.empty())
+        {
+            // after PoeditListCtrl::CatalogChanged()'s own selection reset:
+            CallAfter([=]{
+                if (!m_list || m_catalog != cat)
+                    return;
+                for (unsigned i = 0; i < cat->GetCount(); i++)
+                {
+                    if (keyOf((*cat)[i]) == currentKey)
+                    {
+                        m_list->SelectAndFocus(m_list->CatalogIndexToList((int)i));
+                        break;
+                    }
+                }
+            });
+        }
+        return;
+    }
+
+    // Patch the UI in place, updating only changed, added or removed entries.
+    // The sidebar must forget the old catalog object, same as with a full reload:
+    if (m_sidebar)
+        m_sidebar->ResetCatalog();
+    m_catalog = cat;
+    m_pendingHumanEditedItem.reset();
+    m_modified = false;
+    m_hasObsoleteItems = false;
+
+    m_list->CatalogReloaded(cat, diff);
+    if (m_findWindow)
+        m_findWindow->Reset(m_catalog);
+    if (m_gotoEntryWindow)
+        m_gotoEntryWindow->Reset(m_catalog);
+
+    if (m_list->HasMultipleSelection())
+    {
+        if (m_sidebar)
+            m_sidebar->SetMultipleSelection();
+    }
+    else
+    {
+        UpdateToTextCtrl(EditingArea::ItemChanged);
+        if (m_sidebar)
+            m_sidebar->SetSelectedItem(m_catalog, GetCurrentItem());
+    }
+
+    UpdateMenu();
+    UpdateTitle();
+    UpdateTextLanguage();
+    UpdateStatusBar();
+
+#ifdef HAVE_HTTP_CLIENT
+    m_toolbar->EnableSyncWithCrowdin(m_catalog->IsFromCrowdin());
+#endif
+}
+
+
 void PoeditFrame::MarkAsModified()
 {
     m_modified = true;
@@ -2506,6 +2735,8 @@ void PoeditFrame::RefreshControls(int flags)
 
         if (m_findWindow)
             m_findWindow->Reset(m_catalog);
+        if (m_gotoEntryWindow)
+            m_gotoEntryWindow->Reset(m_catalog);
     }
 
     UpdateTitle();
@@ -2536,11 +2767,16 @@ void PoeditFrame::UpdateStatusBar()
         {
             int percent = (all == 0) ? 0 : (100 * (all - unfinished) / all);
 
+            auto words = GetWordStatistics(m_catalog);
+
             text.Printf(_("Translated: %d of %d (%d %%)"), all - unfinished, all, percent);
             if (unfinished > 0)
             {
                 text += L"  •  ";
                 text += wxString::Format(_("Remaining: %d"), unfinished);
+                text += " (";
+                text += wxString::Format(wxPLURAL("%d word", "%d words", words.remainingWords), words.remainingWords);
+                text += ")";
             }
             if (errors > 0)
             {
@@ -2550,7 +2786,10 @@ void PoeditFrame::UpdateStatusBar()
         }
         else
         {
+            auto words = GetWordStatistics(m_catalog);
             text.Printf(wxPLURAL("%d entry", "%d entries", all), all);
+            text += L"  •  ";
+            text += wxString::Format(wxPLURAL("%d word", "%d words", words.sourceWords), words.sourceWords);
         }
 
         bar->SetStatusText(text);
@@ -2665,12 +2904,16 @@ void PoeditFrame::WriteCatalog(const wxString& catalog, TFunctor completionHandl
 {
     wxBusyCursor bcur;
 
+    if (m_editingArea)
+        m_editingArea->FlushPendingChanges();
+
     dispatch::future<void> tmUpdateThread;
     if (Config::UseTM() && m_catalog->HasCapability(Catalog::Cap::Translations))
     {
         tmUpdateThread = dispatch::async([=]{
             try
             {
+                TranslationMemory::Get().FlushQueuedInserts();
                 auto tm = TranslationMemory::Get().GetWriter();
                 tm->Insert(m_catalog);
                 tm->Commit();
@@ -2706,6 +2949,7 @@ void PoeditFrame::WriteCatalog(const wxString& catalog, TFunctor completionHandl
     m_catalog->SetFileName(catalog);
     m_modified = false;
     m_fileExistsOnDisk = true;
+    NoteFileModificationTime();
 
 #ifndef __WXOSX__
     FileHistory().AddFileToHistory(GetFileName());
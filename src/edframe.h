@@ -29,6 +29,7 @@
 #include <memory>
 #include <set>
 
+#include <wx/datetime.h>
 #include <wx/frame.h>
 #include <wx/process.h>
 #include <wx/msgdlg.h>
@@ -54,6 +55,7 @@ class WXDLLIMPEXP_FWD_CORE wxSplitterEvent;
 class PoeditFrame;
 class AttentionBar;
 class FindFrame;
+class GoToEntryDialog;
 class MainToolbar;
 class Sidebar;
 class EditingArea;
@@ -87,6 +89,10 @@ class PoeditFrame : public PoeditFrameBase
         /// if there's unsaved document.
         void OpenFile(const wxString& filename, int lineno = 0);
 
+        /// Selects the catalog item with given index (in catalog order) once
+        /// the frame finished loading it.
+        void FocusCatalogItem(int index);
+
         /** Returns pointer to existing instance of PoeditFrame that currently
             exists and edits \a catalog. If no such frame exists, returns NULL.
          */
@@ -277,6 +283,7 @@ private:
         void OnSplitterSashMoving(wxSplitterEvent& event);
         void OnSidebarSplitterSashMoving(wxSplitterEvent& event);
         void OnCloseWindow(wxCloseEvent& event);
+        void OnActivate(wxActivateEvent& event);
         void OnReference(wxCommandEvent& event);
         void OnReferencesMenu(wxCommandEvent& event);
         void OnReferencesMenuUpdate(wxUpdateUIEvent& event);
@@ -292,6 +299,7 @@ private:
         void OnFindAndReplace(wxCommandEvent& event);
         void OnFindNext(wxCommandEvent& event);
         void OnFindPrev(wxCommandEvent& event);
+        void OnGoToEntry(wxCommandEvent& event);
         void OnUpdateFind(wxUpdateUIEvent& event);
         void OnEditComment(wxCommandEvent& event);
         void OnSortByFileOrder(wxCommandEvent&);
@@ -348,6 +356,11 @@ private:
 #endif
         void NoteAsRecentFile();
 
+        // Detection of changes to the file made by other programs
+        void NoteFileModificationTime();
+        void CheckForExternalChanges();
+        void ReloadCatalogFromDisk();
+
         void OnNewTranslationEntered(const CatalogItemPtr& item);
 
         DECLARE_EVENT_TABLE()
@@ -356,6 +369,11 @@ private:
         CatalogPtr m_catalog;
 
         bool m_fileExistsOnDisk;
+        // state of the file when it was last loaded or saved, to detect
+        // changes by other applications; the time has sub-second precision
+        // where the filesystem provides it
+        wxDateTime m_fileModificationTime;
+        wxULongLong m_fileSize;
 
         wxString m_fileNamePartOfTitle;
 
@@ -374,6 +392,7 @@ private:
         AttentionBar *m_attentionBar;
         Sidebar *m_sidebar;
         wxWeakRef<FindFrame> m_findWindow;
+        wxWeakRef<GoToEntryDialog> m_gotoEntryWindow;
 
         bool m_modified;
         bool m_hasObsoleteItems;
@@ -48,6 +48,9 @@
 namespace
 {
 
+// Delay after the last keystroke before edits are propagated to the catalog
+const int PENDING_CHANGES_DELAY_MS = 300;
+
 struct EventHandlerDisabler
 {
     EventHandlerDisabler(wxEvtHandler *h) : m_hnd(h)
@@ -479,7 +482,10 @@ void EditingArea::CreateEditControls(wxBoxSizer *sizer)
 
     ShowPluralFormUI(false);
 
-    m_textTrans->Bind(wxEVT_TEXT, [=](wxCommandEvent& e){ e.Skip(); UpdateFromTextCtrl(); });
+    BindTranslationCtrlEvents(m_textTrans);
+
+    m_pendingTimer.SetOwner(this);
+    Bind(wxEVT_TIMER, &EditingArea::OnPendingTimer, this, m_pendingTimer.GetId());
 
     m_fuzzy->Bind(wxEVT_TOGGLEBUTTON, [=](wxCommandEvent& e){
         // The user explicitly changed fuzzy status (e.g. to on). Normally, if the
@@ -549,6 +555,8 @@ void EditingArea::SetupTextCtrlSizes()
 
 EditingArea::~EditingArea()
 {
+    m_pendingTimer.Stop();
+
     // OnPaint may still be called as child windows are destroyed
     m_labelSource = m_labelTrans = nullptr;
 }
@@ -602,17 +610,18 @@ void EditingArea::SetCustomFont(const wxFont& font)
 
 bool EditingArea::InitSpellchecker(bool enabled, Language lang)
 {
+    auto& spellchecker = SpellcheckingService::Get();
     bool rv = true;
 
     if (m_textTrans)
     {
-        if (!InitTextCtrlSpellchecker(m_textTrans, enabled, lang))
+        if (!spellchecker.Attach(m_textTrans, enabled, lang))
             rv = false;
     }
 
     for (auto tp : m_textTransPlural)
     {
-        if (tp && !InitTextCtrlSpellchecker(tp, enabled, lang))
+        if (!spellchecker.Attach(tp, enabled, lang))
             rv = false;
     }
 
@@ -638,8 +647,9 @@ void EditingArea::RecreatePluralTextCtrls(CatalogPtr catalog)
     if (!m_pluralNotebook)
         return;
 
+    FlushPendingChanges();
+
     m_textTransPlural.clear();
-    m_pluralNotebook->DeleteAllPages();
     m_textTransSingularForm = NULL;
 
     auto plurals = PluralFormsExpr(catalog->Header().GetHeader("Plural-Forms").ToStdString());
@@ -718,20 +728,43 @@ void EditingArea::RecreatePluralTextCtrls(CatalogPtr catalog)
         else
             desc.Printf(L"n → %s", examples);
 
-        // create text control and notebook page for it:
-        auto txt = new TranslationTextCtrl(m_pluralNotebook, wxID_ANY);
-        txt->SetWindowVariant(wxWINDOW_VARIANT_NORMAL);
+        // reuse existing text control if possible, create a new one otherwise:
+        if ((size_t)form >= m_pluralPagesPool.size())
+        {
+            auto txt = new TranslationTextCtrl(m_pluralNotebook, wxID_ANY);
+            txt->SetWindowVariant(wxWINDOW_VARIANT_NORMAL);
 #ifndef __WXOSX__
-        txt->SetFont(m_textTrans->GetFont());
+            txt->SetFont(m_textTrans->GetFont());
 #endif
-        txt->Bind(wxEVT_TEXT, [=](wxCommandEvent& e){ e.Skip(); UpdateFromTextCtrl(); });
+            BindTranslationCtrlEvents(txt);
+            m_pluralPagesPool.push_back(txt);
+        }
+
+        auto txt = m_pluralPagesPool[form];
         m_textTransPlural.push_back(txt);
-        m_pluralNotebook->AddPage(txt, desc);
+        if ((size_t)form < m_pluralNotebook->GetPageCount())
+        {
+            m_pluralNotebook->SetPageText(form, desc);
+        }
+        else
+        {
+            txt->Show();
+            m_pluralNotebook->AddPage(txt, desc);
+        }
 
         if (examplesCnt == 1 && firstExample == 1) // == singular
             m_textTransSingularForm = txt;
     }
 
+    // keep pages that aren't needed now around for later reuse:
+    while (m_pluralNotebook->GetPageCount() > (size_t)formsCount)
+    {
+        const size_t last = m_pluralNotebook->GetPageCount() - 1;
+        auto page = m_pluralNotebook->GetPage(last);
+        m_pluralNotebook->RemovePage(last);
+        page->Hide();
+    }
+
     // as a fallback, assume 1st form for plural entries is the singular
     // (like in English and most real-life uses):
     if (!m_textTransSingularForm && !m_textTransPlural.empty())
@@ -828,6 +861,9 @@ void EditingArea::CopyFromSingular()
 
 void EditingArea::UpdateToTextCtrl(CatalogItemPtr item, int flags)
 {
+    // controls' content is about to be replaced, don't lose user's edits
+    FlushPendingChanges();
+
     if (!(flags & DontTouchText))
     {
         auto syntax = SyntaxHighlighter::ForItem(*item);
@@ -919,13 +955,86 @@ void EditingArea::UpdateAuxiliaryInfo(CatalogItemPtr item)
 }
 
 
+void EditingArea::BindTranslationCtrlEvents(TranslationTextCtrl *ctrl)
+{
+    ctrl->Bind(wxEVT_TEXT, [=](wxCommandEvent& e){ e.Skip(); MarkTextCtrlDirty(ctrl); });
+    ctrl->Bind(wxEVT_KILL_FOCUS, [=](wxFocusEvent& e){
+        e.Skip();
+        if (!IsBeingDeleted())
+            FlushPendingChanges();
+    });
+}
+
+
+void EditingArea::MarkTextCtrlDirty(TranslationTextCtrl *ctrl)
+{
+    // This is called on every keystroke, so it must be cheap and mustn't
+    // depend on the size of the text; the real work is done later in
+    // FlushPendingChanges().
+    if (!m_pendingItem)
+    {
+        m_pendingItem = m_associatedList->GetCurrentCatalogItem();
+        if (!m_pendingItem)
+            return;
+        m_pendingListItem = m_associatedList->GetCurrentItem();
+    }
+
+    if (std::find(m_dirtyCtrls.begin(), m_dirtyCtrls.end(), ctrl) == m_dirtyCtrls.end())
+        m_dirtyCtrls.push_back(ctrl);
+
+    // coalesce consecutive keystrokes into a single update (restarts the timer):
+    m_pendingTimer.StartOnce(PENDING_CHANGES_DELAY_MS);
+}
+
+
+void EditingArea::OnPendingTimer(wxTimerEvent&)
+{
+    FlushPendingChanges();
+}
+
+
+void EditingArea::FlushPendingChanges()
+{
+    m_pendingTimer.Stop();
+    if (!m_pendingItem)
+        return;
+
+    // reset the state first, DoUpdateFromTextCtrl() may result in reentrancy
+    auto item = m_pendingItem;
+    auto listItem = m_pendingListItem;
+    std::vector<TranslationTextCtrl*> dirty;
+    dirty.swap(m_dirtyCtrls);
+    m_pendingItem.reset();
+    m_pendingListItem = wxDataViewItem();
+
+    DoUpdateFromTextCtrl(item, listItem, &dirty);
+}
+
+
 void EditingArea::UpdateFromTextCtrl()
 {
     auto item = m_associatedList->GetCurrentCatalogItem();
     if (!item)
         return;
 
-    wxString key = item->GetString();
+    // everything is re-read from the controls, pending edits included
+    m_pendingTimer.Stop();
+    m_pendingItem.reset();
+    m_pendingListItem = wxDataViewItem();
+    m_dirtyCtrls.clear();
+
+    DoUpdateFromTextCtrl(item, m_associatedList->GetCurrentItem(), nullptr);
+}
+
+
+void EditingArea::DoUpdateFromTextCtrl(CatalogItemPtr item, const wxDataViewItem& listItem,
+                                       const std::vector<TranslationTextCtrl*> *onlyDirty)
+{
+    auto isDirty = [onlyDirty](TranslationTextCtrl *ctrl)
+    {
+        return !onlyDirty || std::find(onlyDirty->begin(), onlyDirty->end(), ctrl) != onlyDirty->end();
+    };
+
     bool newfuzzy = m_fuzzy->GetValue();
 
     const bool oldIsTranslated = item->IsTranslated();
@@ -934,24 +1043,39 @@ void EditingArea::UpdateFromTextCtrl()
 
     if (item->HasPlural())
     {
-        wxArrayString str;
-        for (unsigned i = 0; i < m_textTransPlural.size(); i++)
+        // Controls that weren't touched still hold the item's translations,
+        // so only re-read (and compare) the dirty ones:
+        wxArrayString str(item->GetTranslations());
+        const size_t formsCount = m_textTransPlural.size();
+        if (str.size() != formsCount)
         {
-            auto val = PreprocessEnteredTextForItem(item, m_textTransPlural[i]->GetPlainText());
-            str.Add(val);
-            if ( val.empty() )
-                allTranslated = false;
+            str.resize(formsCount);
+            anyTransChanged = true;
         }
 
-        if ( str != item->GetTranslations() )
+        for (size_t i = 0; i < formsCount; i++)
         {
-            anyTransChanged = true;
-            item->SetTranslations(str);
+            if (isDirty(m_textTransPlural[i]))
+            {
+                auto val = PreprocessEnteredTextForItem(item, m_textTransPlural[i]->GetPlainText());
+                if (val != str[i])
+                {
+                    str[i] = val;
+                    anyTransChanged = true;
+                }
+            }
+            if ( str[i].empty() )
+                allTranslated = false;
         }
+
+        if (anyTransChanged)
+            item->SetTranslations(str);
     }
     else
     {
-        auto newval = PreprocessEnteredTextForItem(item, m_textTrans->GetPlainText());
+        auto newval = isDirty(m_textTrans)
+                      ? PreprocessEnteredTextForItem(item, m_textTrans->GetPlainText())
+                      : item->GetTranslation();
 
         if ( newval.empty() )
             allTranslated = false;
@@ -990,7 +1114,8 @@ void EditingArea::UpdateFromTextCtrl()
 
     UpdateAuxiliaryInfo(item);
 
-    m_associatedList->RefreshItem(m_associatedList->GetCurrentItem());
+    if (listItem.IsOk())
+        m_associatedList->RefreshItem(listItem);
 
     if (OnUpdatedFromTextCtrl)
         OnUpdatedFromTextCtrl(item, statisticsChanged);
@@ -28,7 +28,9 @@
 
 #include "catalog.h"
 
+#include <wx/dataview.h>
 #include <wx/panel.h>
+#include <wx/timer.h>
 
 #include <functional>
 #include <vector>
@@ -98,6 +100,21 @@ public:
     /// Puts text from textctrls to catalog & listctrl.
     void UpdateFromTextCtrl();
 
+    /**
+        Commits edits made in the text controls that weren't propagated
+        to the catalog yet.
+
+        User's typing only marks the edited control as dirty, the (potentially
+        expensive) update of the catalog item is deferred until a short pause
+        in typing, focus change or an explicit call to this method. Call it before
+        anything that reads or modifies the current item or changes the
+        selection.
+     */
+    void FlushPendingChanges();
+
+    /// Returns true if there are uncommitted edits in the text controls.
+    bool HasPendingChanges() const { return m_pendingItem != nullptr; }
+
     void DontAutoclearFuzzyStatus() { m_dontAutoclearFuzzyStatus = true; }
     bool ShouldNotAutoclearFuzzyStatus() { return m_dontAutoclearFuzzyStatus; }
 
@@ -114,6 +131,14 @@ public:
 private:
     void UpdateAuxiliaryInfo(CatalogItemPtr item);
 
+    /// Called on every keystroke, only records that @a ctrl changed.
+    void MarkTextCtrlDirty(TranslationTextCtrl *ctrl);
+    void BindTranslationCtrlEvents(TranslationTextCtrl *ctrl);
+    void OnPendingTimer(wxTimerEvent& e);
+
+    void DoUpdateFromTextCtrl(CatalogItemPtr item, const wxDataViewItem& listItem,
+                              const std::vector<TranslationTextCtrl*> *onlyDirty);
+
     void CreateEditControls(wxBoxSizer *sizer);
     void CreateTemplateControls(wxBoxSizer *sizer);
     void SetupTextCtrlSizes();
@@ -139,6 +164,11 @@ private:
     std::vector<TranslationTextCtrl*> m_textTransPlural;
     TranslationTextCtrl *m_textTransSingularForm;
 
+    // Plural form pages are never destroyed, only removed from the notebook,
+    // so that they can be reused by RecreatePluralTextCtrls(). The first
+    // m_textTransPlural.size() of them are currently in use.
+    std::vector<TranslationTextCtrl*> m_pluralPagesPool;
+
     wxNotebook *m_pluralNotebook;
     wxStaticText *m_labelSingular, *m_labelPlural;
     wxStaticText *m_labelSource, *m_labelTrans;
@@ -148,6 +178,12 @@ private:
     TagLabel *m_tagPretranslated;
 
     IssueLabel *m_issueLine;
+
+    // deferred updates from text controls:
+    CatalogItemPtr m_pendingItem;
+    wxDataViewItem m_pendingListItem;
+    std::vector<TranslationTextCtrl*> m_dirtyCtrls;
+    wxTimer m_pendingTimer;
 };
 
 #endif // Poedit_editing_area_h
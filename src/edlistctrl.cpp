@@ -57,6 +57,12 @@
 namespace
 {
 
+// Notifying about every changed row is slow with large selections (e.g.
+// after Select All), because native controls do per-row bookkeeping.
+// Past some point, it's much faster to reset the model and restore
+// selection afterwards.
+const size_t BULK_CHANGE_THRESHOLD = 500;
+
 class SelectionPreserver
 {
 public:
@@ -255,6 +261,58 @@ void PoeditListCtrl::Model::SetCatalog(CatalogPtr catalog)
 }
 
 
+void PoeditListCtrl::Model::SetReloadedCatalog(CatalogPtr catalog, const Catalog::ReloadDiff& diff)
+{
+    const std::vector<int> oldCatalogToList(m_mapCatalogToList);
+
+    m_catalog = catalog;
+    CreateSortMap();
+
+    // Notifying about individual rows is only possible if the items present
+    // in both versions kept their relative order, and only worth it if there
+    // aren't too many of them:
+    bool keptOrder = diff.addedItems.size() + diff.removedItems.size() < BULK_CHANGE_THRESHOLD;
+    int lastOldRow = -1;
+    for (size_t row = 0; keptOrder && row < m_mapListToCatalog.size(); row++)
+    {
+        const int oldIndex = diff.oldIndexes[m_mapListToCatalog[row]];
+        if (oldIndex == -1)
+            continue;
+        const int oldRow = oldCatalogToList[oldIndex];
+        keptOrder = oldRow > lastOldRow;
+        lastOldRow = oldRow;
+    }
+
+    if (!keptOrder)
+    {
+        Reset(catalog->GetCount());
+        return;
+    }
+
+    if (!diff.removedItems.empty())
+    {
+        wxArrayInt rows;
+        for (auto i: diff.removedItems)
+            rows.push_back(oldCatalogToList[i]);
+        RowsDeleted(rows);
+    }
+
+    // inserting in increasing order puts each row at its final position:
+    std::vector<int> addedRows;
+    for (auto i: diff.addedItems)
+        addedRows.push_back(m_mapCatalogToList[i]);
+    std::sort(addedRows.begin(), addedRows.end());
+    for (auto row: addedRows)
+        RowInserted(row);
+
+    wxDataViewItemArray changed;
+    for (auto i: diff.changedItems)
+        changed.push_back(GetItem(m_mapCatalogToList[i]));
+    if (!changed.empty())
+        ItemsChanged(changed);
+}
+
+
 void PoeditListCtrl::Model::UpdateSort()
 {
     if (!m_catalog)
@@ -775,6 +833,91 @@ void PoeditListCtrl::CatalogChanged(const CatalogPtr& catalog)
 }
 
 
+void PoeditListCtrl::CatalogReloaded(const CatalogPtr& catalog, const Catalog::ReloadDiff& diff)
+{
+    wxASSERT( catalog && m_catalog && diff.oldIndexes.size() == catalog->GetCount() );
+
+    if (diff.HasSameItems())
+    {
+        // Items' positions only change if sorting depends on what was modified:
+        const SortOrder& order = m_model->sortOrder;
+        bool needsSort = false;
+        for (auto i: diff.changedItems)
+        {
+            auto a = (*m_catalog)[i];
+            auto b = (*catalog)[i];
+            if ((order.by == SortOrder::By_Translation && a->GetTranslations() != b->GetTranslations()) ||
+                (order.untransFirst && (a->IsTranslated() != b->IsTranslated() || a->IsFuzzy() != b->IsFuzzy())) ||
+                (order.errorsFirst && (a->HasIssue() != b->HasIssue() || a->HasError() != b->HasError() || a->IsFuzzy() != b->IsFuzzy())))
+            {
+                needsSort = true;
+                break;
+            }
+        }
+
+        m_catalog = catalog;
+        m_model->m_catalog = catalog;
+
+        if (needsSort)
+        {
+            Sort();
+            return;
+        }
+
+        wxDataViewItemArray items;
+        items.reserve(diff.changedItems.size());
+        for (auto i: diff.changedItems)
+            items.push_back(CatalogIndexToListItem(i));
+        RefreshItems(items);
+        return;
+    }
+
+    // Items were added, removed or moved: remember the selection in terms of
+    // the reloaded catalog's indexes.
+    std::vector<int> newIndexes(m_catalog->GetCount(), -1);
+    for (size_t i = 0; i < diff.oldIndexes.size(); i++)
+    {
+        if (diff.oldIndexes[i] != -1)
+            newIndexes[diff.oldIndexes[i]] = (int)i;
+    }
+
+    std::vector<int> selection;
+    for (auto i: GetSelectedCatalogItemIndexes())
+    {
+        if (newIndexes[i] != -1)
+            selection.push_back(newIndexes[i]);
+    }
+    const int focusRow = ListItemToListIndex(GetCurrentItem());
+    int focus = ListItemToCatalogIndex(GetCurrentItem());
+    if (focus != -1)
+        focus = newIndexes[focus];
+
+    {
+        wxWindowUpdateLocker no_updates(this);
+        m_catalog = catalog;
+        m_model->SetReloadedCatalog(catalog, diff);
+    }
+
+    const int count = GetItemCount();
+    if (count == 0)
+        return;
+
+    if (!selection.empty())
+        SetSelectedCatalogItemIndexes(selection);
+    if (focus != -1)
+    {
+        auto item = CatalogIndexToListItem(focus);
+        EnsureVisible(item);
+        SetCurrentItem(item);
+    }
+    else if (selection.empty())
+    {
+        // the current item was removed, select whatever is at its place now:
+        SelectAndFocus(std::min(std::max(focusRow, 0), count - 1));
+    }
+}
+
+
 void PoeditListCtrl::RefreshAllItems()
 {
     // Can't use Cleared() here because it messes up selection and scroll position
@@ -787,6 +930,19 @@ void PoeditListCtrl::RefreshAllItems()
 }
 
 
+void PoeditListCtrl::RefreshItems(const wxDataViewItemArray& items)
+{
+    if (items.size() < BULK_CHANGE_THRESHOLD)
+    {
+        m_model->ItemsChanged(items);
+        return;
+    }
+
+    SelectionPreserver preserve(this);
+    m_model->Reset(m_model->GetCount());
+}
+
+
 void PoeditListCtrl::Sort()
 {
     if (!m_catalog)
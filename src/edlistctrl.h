@@ -57,6 +57,17 @@ class PoeditListCtrl : public wxDataViewCtrl
 
         void CatalogChanged(const CatalogPtr& catalog);
 
+        /**
+            Switches to another version of the same catalog, e.g. one reloaded
+            after it was modified externally.
+
+            @a diff describes differences between the two versions, as found by
+            Catalog::CompareWithReloaded(). Unlike CatalogChanged(), this keeps
+            sort order, selection and scroll position and only updates rows of
+            changed, added or removed items.
+         */
+        void CatalogReloaded(const CatalogPtr& catalog, const Catalog::ReloadDiff& diff);
+
         int ListItemToListIndex(const wxDataViewItem& item) const
         {
             return item.IsOk() ? m_model->GetRow(item) : -1;
@@ -145,9 +156,12 @@ class PoeditListCtrl : public wxDataViewCtrl
             GetSelections(sel);
             for (auto item: sel)
                 func(*ListItemToCatalogItem(item));
-            m_model->ItemsChanged(sel);
+            RefreshItems(sel);
         }
 
+        /// Refreshes given items, efficiently even if there's a lot of them.
+        void RefreshItems(const wxDataViewItemArray& items);
+
         void SelectOnly(const wxDataViewItem& item)
         {
             wxDataViewItemArray sel;
@@ -243,6 +257,7 @@ class PoeditListCtrl : public wxDataViewCtrl
             virtual ~Model() {}
 
             void SetCatalog(CatalogPtr catalog);
+            void SetReloadedCatalog(CatalogPtr catalog, const Catalog::ReloadDiff& diff);
             void UpdateSort();
 
             unsigned int GetColumnCount() const override { return Col_Max; }
@@ -33,6 +33,12 @@
 #include <wx/textctrl.h>
 #include <wx/checkbox.h>
 #include <wx/notebook.h>
+#include <wx/log.h>
+
+#include <algorithm>
+#include <cwchar>
+#include <regex>
+#include <thread>
 
 #ifdef __WXOSX__
 #include <AppKit/AppKit.h>
@@ -44,12 +50,14 @@
 #endif
 
 #include "catalog.h"
+#include "concurrency.h"
 #include "text_control.h"
 #include "edframe.h"
 #include "editing_area.h"
 #include "edlistctrl.h"
 #include "findframe.h"
 #include "hidpi.h"
+#include "str_helpers.h"
 #include "utility.h"
 
 namespace
@@ -82,7 +90,8 @@ FindFrame::FindFrame(PoeditFrame *owner,
           m_listCtrl(list),
           m_editingArea(editingArea),
           m_catalog(c),
-          m_position(-1)
+          m_position(-1),
+          m_regexFlags()
 {
     auto panel = new wxPanel(this, wxID_ANY);
     wxBoxSizer *panelsizer = new wxBoxSizer(wxVERTICAL);
@@ -119,6 +128,7 @@ FindFrame::FindFrame(PoeditFrame *owner,
     m_ignoreCase = new wxCheckBox(collPane, wxID_ANY, _("Ignore case"));
     m_wrapAround = new wxCheckBox(collPane, wxID_ANY, _("Wrap around"));
     m_wholeWords = new wxCheckBox(collPane, wxID_ANY, _("Whole words only"));
+    m_useRegex = new wxCheckBox(collPane, wxID_ANY, _("Regular expressions"));
     m_findInOrig = new wxCheckBox(collPane, wxID_ANY, _("Find in source texts"));
     m_findInTrans = new wxCheckBox(collPane, wxID_ANY, _("Find in translations"));
     m_findInComments = new wxCheckBox(collPane, wxID_ANY, _("Find in comments"));
@@ -131,6 +141,7 @@ FindFrame::FindFrame(PoeditFrame *owner,
     optionsL->Add(m_ignoreCase, wxSizerFlags().Expand());
     optionsL->Add(m_wrapAround, wxSizerFlags().Expand().Border(wxTOP, PX(2)));
     optionsL->Add(m_wholeWords, wxSizerFlags().Expand().Border(wxTOP, PX(2)));
+    optionsL->Add(m_useRegex, wxSizerFlags().Expand().Border(wxTOP, PX(2)));
     optionsR->Add(m_findInOrig, wxSizerFlags().Expand().Border(wxTOP, PX(2)));
     optionsR->Add(m_findInTrans, wxSizerFlags().Expand().Border(wxTOP, PX(2)));
     optionsR->Add(m_findInComments, wxSizerFlags().Expand().Border(wxTOP, PX(2)));
@@ -179,6 +190,7 @@ FindFrame::FindFrame(PoeditFrame *owner,
     m_ignoreCase->SetValue(!wxConfig::Get()->ReadBool("find_case_sensitive", false));
     m_wrapAround->SetValue(wxConfig::Get()->ReadBool("find_wrap_around", true));
     m_wholeWords->SetValue(wxConfig::Get()->ReadBool("whole_words", false));
+    m_useRegex->SetValue(wxConfig::Get()->ReadBool("find_regex", false));
 
     wxAcceleratorEntry entries[] = {
 #ifndef __WXGTK__
@@ -334,6 +346,7 @@ void FindFrame::OnCheckbox(wxCommandEvent&)
     wxConfig::Get()->Write("find_case_sensitive", !m_ignoreCase->GetValue());
     wxConfig::Get()->Write("find_wrap_around", m_wrapAround->GetValue());
     wxConfig::Get()->Write("whole_words", m_wholeWords->GetValue());
+    wxConfig::Get()->Write("find_regex", m_useRegex->GetValue());
 }
 
 
@@ -417,19 +430,6 @@ bool IsTextInString(wxString str, const wxString& text,
                                  [=](const wxString&,size_t,size_t){ return wxString::npos;/*just 1 hit*/ });
 }
 
-size_t IsTextInStrings(const wxArrayString& strs, const wxString& text,
-                     bool ignoreCase, bool wholeWords, bool ignoreAmp, bool ignoreUnderscore)
-{
-    // loop through all strings and search for the substring in them
-    for (size_t i = 0; i < strs.GetCount(); i++)
-    {
-        if (IsTextInString(strs[i], text, ignoreCase, wholeWords, ignoreAmp, ignoreUnderscore))
-            return i;
-    }
-
-    return -1;
-}
-
 bool ReplaceTextInString(wxString& str, const wxString& text, bool wholeWords, const wxString& replacement)
 {
     return FindTextInStringAndDo(str, text, wholeWords,
@@ -449,8 +449,117 @@ enum FoundState
     Found_InExtractedComments
 };
 
+// Regex search in wxString's data, without copying it
+bool RegexSearchInString(const wxString& str, const std::wregex& re, size_t *pos = nullptr, size_t *len = nullptr)
+{
+    auto buf = str.wc_str();
+    const wchar_t *begin = buf;
+    std::wcmatch m;
+    try
+    {
+        if (!std::regex_search(begin, begin + wcslen(begin), m, re))
+            return false;
+    }
+    catch (std::regex_error&)
+    {
+        // e.g. error_complexity on huge strings, see RegexSyntaxHighlighter
+        return false;
+    }
+
+    if (pos)
+        *pos = (size_t)m.position(0);
+    if (len)
+        *len = (size_t)m.length(0);
+    return true;
+}
+
+/// Tests catalog items against the search options; safe to use from multiple threads
+struct ItemMatcher
+{
+    bool inTrans, inSource, inComments;
+    bool ignoreCase, wholeWords, ignoreAmp, ignoreUnderscore;
+
+    // substring to search for, if regex is null
+    wxString text;
+    // compiled regular expression, if in regex mode
+    const std::wregex *regex = nullptr;
+
+    bool Test(const wxString& str, bool ignoreMnemonics) const
+    {
+        if (regex)
+            return RegexSearchInString(str, *regex);
+        else
+            return IsTextInString(str, text, ignoreCase, wholeWords,
+                                  ignoreMnemonics && ignoreAmp, ignoreMnemonics && ignoreUnderscore);
+    }
+
+    FoundState Match(const CatalogItem& dt, size_t& trans) const
+    {
+        if (inTrans)
+        {
+            const auto& translations = dt.GetTranslations();
+            for (size_t i = 0; i < translations.size(); i++)
+            {
+                if (Test(translations[i], true))
+                {
+                    trans = i;
+                    return Found_InTrans;
+                }
+            }
+        }
+        if (inSource)
+        {
+            if (Test(dt.GetString(), true))
+                return Found_InOrig;
+            if (dt.HasPlural() && Test(dt.GetPluralString(), true))
+                return Found_InOrigPlural;
+        }
+        if (inComments)
+        {
+            if (Test(dt.GetComment(), false))
+                return Found_InComments;
+            for (auto& c: dt.GetExtractedComments())
+            {
+                if (Test(c, false))
+                    return Found_InExtractedComments;
+            }
+        }
+        return Found_Not;
+    }
+};
+
+// Regex search is evaluated on this many items per background task
+const int PARALLEL_CHUNK_SIZE = 1000;
+
 } // anonymous space
 
+
+const std::wregex *FindFrame::GetCompiledRegex(bool ignoreCase, bool wholeWords)
+{
+    auto flags = std::regex_constants::ECMAScript | std::regex_constants::optimize;
+    if (ignoreCase)
+        flags |= std::regex_constants::icase;
+    const wxString pattern = wholeWords ? "\\b(?:" + ms_text + ")\\b" : ms_text;
+
+    // compile only once per search, not on every Find Next or for every item:
+    if (pattern == m_regexPattern && flags == m_regexFlags)
+        return m_regex.get();
+
+    m_regexPattern = pattern;
+    m_regexFlags = flags;
+    m_regex.reset();
+    try
+    {
+        m_regex = std::make_shared<std::wregex>(str::to_wstring(pattern), flags);
+    }
+    catch (std::regex_error& e)
+    {
+        wxLogError(_("Invalid regular expression: %s"), e.what());
+    }
+    return m_regex.get();
+}
+
+
 bool FindFrame::DoFind(int dir)
 {
     wxASSERT( dir == +1 || dir == -1 );
@@ -460,84 +569,143 @@ bool FindFrame::DoFind(int dir)
 
     int mode = m_mode->GetSelection();
     int cnt = m_listCtrl->GetItemCount();
-    bool inTrans = m_findInTrans->GetValue() && (m_catalog->HasCapability(Catalog::Cap::Translations));
-    bool inSource = (mode == Mode_Find) && m_findInOrig->GetValue();
-    bool inComments = (mode == Mode_Find) && m_findInComments->GetValue();
-    bool ignoreCase = (mode == Mode_Find) && m_ignoreCase->GetValue();
-    bool wholeWords = m_wholeWords->GetValue();
+    bool useRegex = m_useRegex->GetValue();
     bool wrapAround = m_wrapAround->GetValue();
     int posOrig = m_position;
-    size_t trans;
+    size_t trans = 0;
 
-    FoundState found = Found_Not;
-    CatalogItemPtr lastItem;
+    ItemMatcher matcher;
+    matcher.inTrans = m_findInTrans->GetValue() && (m_catalog->HasCapability(Catalog::Cap::Translations));
+    matcher.inSource = (mode == Mode_Find) && m_findInOrig->GetValue();
+    matcher.inComments = (mode == Mode_Find) && m_findInComments->GetValue();
+    matcher.ignoreCase = (mode == Mode_Find) && m_ignoreCase->GetValue();
+    matcher.wholeWords = m_wholeWords->GetValue();
 
-    wxString textc;
-    wxString text(ms_text);
+    if (useRegex)
+    {
+        matcher.regex = GetCompiledRegex(matcher.ignoreCase, matcher.wholeWords);
+        if (!matcher.regex)
+            return false;
+        matcher.ignoreAmp = matcher.ignoreUnderscore = false;
+    }
+    else
+    {
+        matcher.text = ms_text;
+        if (matcher.ignoreCase)
+            matcher.text.MakeLower();
+
+        // Only ignore mnemonics when searching if the text being searched for
+        // doesn't contain them. That's a reasonable heuristics: most of the time,
+        // ignoring them is the right thing to do and provides better results. But
+        // sometimes, people want to search for them.
+        matcher.ignoreAmp = (mode == Mode_Find) && (matcher.text.Find(_T('&')) == wxNOT_FOUND);
+        matcher.ignoreUnderscore = (mode == Mode_Find) && (matcher.text.Find(_T('_')) == wxNOT_FOUND);
+    }
 
-    if (ignoreCase)
-        text.MakeLower();
-
-    // Only ignore mnemonics when searching if the text being searched for
-    // doesn't contain them. That's a reasonable heuristics: most of the time,
-    // ignoring them is the right thing to do and provides better results. But
-    // sometimes, people want to search for them.
-    const bool ignoreAmp = (mode == Mode_Find) && (text.Find(_T('&')) == wxNOT_FOUND);
-    const bool ignoreUnderscore = (mode == Mode_Find) && (text.Find(_T('_')) == wxNOT_FOUND);
-
-    int oldPosition = m_position;
-    m_position = oldPosition + dir;
-    for (int tested = 0; tested < cnt; ++tested, m_position += dir)
+    // Returns list index of the n-th tested item, or -1 if past the end
+    const int oldPosition = m_position;
+    auto positionAt = [=](int n)
     {
-        if (m_position < 0)
+        int pos = oldPosition + dir * (n + 1);
+        if (pos < 0)
         {
-            if (wrapAround)
-                m_position += cnt;
-            else
-                break;
+            if (!wrapAround)
+                return -1;
+            pos += cnt;
         }
-        else if (m_position >= cnt)
+        else if (pos >= cnt)
         {
-            if (wrapAround)
-                m_position -= cnt;
-            else
-                break;
+            if (!wrapAround)
+                return -1;
+            pos -= cnt;
         }
+        return pos;
+    };
 
-        auto dt = lastItem = (*m_catalog)[m_listCtrl->ListIndexToCatalog(m_position)];
+    FoundState found = Found_Not;
+    CatalogItemPtr lastItem;
 
-        if (inTrans)
+    if (useRegex && cnt >= 2 * PARALLEL_CHUNK_SIZE)
+    {
+        // Evaluate the items in parallel, one window of chunks at a time so
+        // that a hit near the current position doesn't require scanning the
+        // whole catalog. Chunks are checked in search order, so the reported
+        // hit is the same as with sequential search.
+        struct ChunkResult
         {
-            trans = IsTextInStrings(dt->GetTranslations(), text, ignoreCase, wholeWords, ignoreAmp, ignoreUnderscore);
-            if (trans != (size_t)-1)
-            {
-                found = Found_InTrans;
-                break;
-            }
-        }
-        if (inSource)
+            int n = -1;
+            FoundState found = Found_Not;
+            size_t trans = 0;
+        };
+
+        const int windowSize = PARALLEL_CHUNK_SIZE * std::max(1, (int)std::thread::hardware_concurrency());
+        for (int windowStart = 0; windowStart < cnt && found == Found_Not; windowStart += windowSize)
         {
-            if (IsTextInString(dt->GetString(), text, ignoreCase, wholeWords, ignoreAmp, ignoreUnderscore))
+            std::vector<CatalogItemPtr> items;
+            for (int n = windowStart; n < std::min(cnt, windowStart + windowSize); n++)
             {
-                found = Found_InOrig;
+                int pos = positionAt(n);
+                if (pos == -1)
+                    break;
+                items.push_back((*m_catalog)[m_listCtrl->ListIndexToCatalog(pos)]);
+            }
+            if (items.empty())
                 break;
+
+            std::vector<dispatch::future<ChunkResult>> chunks;
+            for (size_t begin = 0; begin < items.size(); begin += PARALLEL_CHUNK_SIZE)
+            {
+                const size_t end = std::min(items.size(), begin + PARALLEL_CHUNK_SIZE);
+                chunks.push_back(dispatch::async([&items, &matcher, begin, end, windowStart]{
+                    ChunkResult r;
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        r.found = matcher.Match(*items[i], r.trans);
+                        if (r.found != Found_Not)
+                        {
+                            r.n = windowStart + (int)i;
+                            break;
+                        }
+                    }
+                    return r;
+                }));
             }
-            if (dt->HasPlural() && IsTextInString(dt->GetPluralString(), text, ignoreCase, wholeWords, ignoreAmp, ignoreUnderscore))
+
+            // NB: must wait for all chunks, they reference local data
+            std::vector<ChunkResult> results;
+            for (auto& c: chunks)
+                results.push_back(c.get());
+
+            for (auto& r: results)
             {
-                found = Found_InOrigPlural;
-                break;
+                if (r.found != Found_Not)
+                {
+                    found = r.found;
+                    trans = r.trans;
+                    m_position = positionAt(r.n);
+                    lastItem = items[r.n - windowStart];
+                    break;
+                }
             }
+
+            if ((int)items.size() < windowSize)
+                break;
         }
-        if (inComments)
+    }
+    else
+    {
+        for (int n = 0; n < cnt; n++)
         {
-            if (IsTextInString(dt->GetComment(), text, ignoreCase, wholeWords, false, false))
-            {
-                found = Found_InComments;
+            int pos = positionAt(n);
+            if (pos == -1)
                 break;
-            }
-            if (IsTextInStrings(dt->GetExtractedComments(), text, ignoreCase, wholeWords, false, false) != (size_t)-1)
+
+            auto dt = (*m_catalog)[m_listCtrl->ListIndexToCatalog(pos)];
+            found = matcher.Match(*dt, trans);
+            if (found != Found_Not)
             {
-                found = Found_InExtractedComments;
+                m_position = pos;
+                lastItem = dt;
                 break;
             }
         }
@@ -580,18 +748,27 @@ bool FindFrame::DoFind(int dir)
 
         if (txt)
         {
-            textc = txt->GetValue();
-            if (ignoreCase)
-                textc.MakeLower();
-            FindTextInStringAndDo
-            (
-                textc, text, wholeWords,
-                [=](const wxString&,size_t pos, size_t len)
-                {
+            wxString textc = txt->GetValue();
+            if (matcher.regex)
+            {
+                size_t pos, len;
+                if (RegexSearchInString(textc, *matcher.regex, &pos, &len))
                     txt->ShowFindIndicator((int)pos, (int)len);
-                    return wxString::npos;
-                }
-            );
+            }
+            else
+            {
+                if (matcher.ignoreCase)
+                    textc.MakeLower();
+                FindTextInStringAndDo
+                (
+                    textc, matcher.text, matcher.wholeWords,
+                    [=](const wxString&,size_t pos, size_t len)
+                    {
+                        txt->ShowFindIndicator((int)pos, (int)len);
+                        return wxString::npos;
+                    }
+                );
+            }
         }
 
         return true;
@@ -607,12 +784,39 @@ bool FindFrame::DoReplaceInItem(CatalogItemPtr item)
     auto search = m_searchField->GetValue();
     auto replace = m_replaceField->GetValue();
 
+    const std::wregex *regex = nullptr;
+    std::wstring regexReplace;
+    if (m_useRegex->GetValue())
+    {
+        regex = GetCompiledRegex(false, wholeWords);
+        if (!regex)
+            return false;
+        // ECMAScript format: $1, $2... refer to capture groups, $& to the whole match
+        regexReplace = str::to_wstring(replace);
+    }
+
     bool replaced = false;
     auto translations = item->GetTranslations();
     for (auto& t: translations)
     {
-        if (ReplaceTextInString(t, search, wholeWords, replace))
+        if (regex)
+        {
+            if (!RegexSearchInString(t, *regex))
+                continue;
+            try
+            {
+                t = std::regex_replace(str::to_wstring(t), *regex, regexReplace);
+                replaced = true;
+            }
+            catch (std::regex_error&)
+            {
+                // leave the string untouched, same as with failed search
+            }
+        }
+        else if (ReplaceTextInString(t, search, wholeWords, replace))
+        {
             replaced = true;
+        }
     }
 
     if (replaced)
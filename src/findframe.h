@@ -31,6 +31,9 @@
 #include <wx/frame.h>
 #include <wx/weakref.h>
 
+#include <memory>
+#include <regex>
+
 class WXDLLIMPEXP_FWD_CORE wxButton;
 class WXDLLIMPEXP_FWD_CORE wxCheckBox;
 class WXDLLIMPEXP_FWD_CORE wxChoice;
@@ -87,11 +90,12 @@ class FindFrame : public wxFrame
         void OnReplaceAll(wxCommandEvent &event);
         bool DoFind(int dir);
         bool DoReplaceInItem(CatalogItemPtr item);
+        const std::wregex *GetCompiledRegex(bool ignoreCase, bool wholeWords);
 
         PoeditFrame *m_owner;
         wxChoice *m_mode;
         wxTextCtrl *m_searchField, *m_replaceField;
-        wxCheckBox *m_ignoreCase, *m_wrapAround, *m_wholeWords,
+        wxCheckBox *m_ignoreCase, *m_wrapAround, *m_wholeWords, *m_useRegex,
                    *m_findInOrig, *m_findInTrans, *m_findInComments;
 
         wxWeakRef<PoeditListCtrl> m_listCtrl;
@@ -99,6 +103,11 @@ class FindFrame : public wxFrame
         CatalogPtr m_catalog;
         int m_position;
         CatalogItemPtr m_lastItem;
+
+        // last compiled regex, reused for as long as the pattern is the same
+        std::shared_ptr<std::wregex> m_regex;
+        wxString m_regexPattern;
+        std::regex_constants::syntax_option_type m_regexFlags;
         wxButton *m_btnClose, *m_btnReplaceAll, *m_btnReplace, *m_btnPrev, *m_btnNext;
 
         // NB: this is static so that last search term is remembered
@@ -0,0 +1,604 @@
+/*
+ *  This file is part of Poedit (https://poedit.net)
+ *
+ *  Copyright (C) 2020 Vaclav Slavik
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "goto_entry.h"
+
+#include "concurrency.h"
+#include "edframe.h"
+#include "hidpi.h"
+
+#include <wx/listbox.h>
+#include <wx/sizer.h>
+#include <wx/textctrl.h>
+#include <wx/utils.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cwctype>
+
+namespace
+{
+
+// Number of best matches shown in the palette
+const size_t MAX_RESULTS = 50;
+
+// How long may searching take while the user is typing, before the results
+// found so far are shown and the rest of the search is done in background
+const auto TYPING_BUDGET = std::chrono::milliseconds(30);
+
+// Maximum length of text shown in the results list
+const size_t MAX_LABEL_LENGTH = 120;
+
+const size_t PARALLEL_CHUNK_SIZE = 5000;
+
+// How often to check the deadline while searching, in entries
+const size_t DEADLINE_CHECK_INTERVAL = 256;
+
+// Scoring constants, modeled after fzf's
+const int SCORE_MATCH = 16;
+const int SCORE_GAP_START = -3;
+const int SCORE_GAP_EXTENSION = -1;
+const int BONUS_BOUNDARY = SCORE_MATCH / 2;
+const int BONUS_NON_WORD = SCORE_MATCH / 2;
+const int BONUS_DIGIT = BONUS_BOUNDARY + SCORE_GAP_EXTENSION;
+const int BONUS_CONSECUTIVE = -(SCORE_GAP_START + SCORE_GAP_EXTENSION);
+const int BONUS_FIRST_CHAR_MULTIPLIER = 2;
+
+
+// Appends case-folded text with all whitespace collapsed into single spaces
+void AppendFolded(std::wstring& out, const wxString& text)
+{
+    for (auto i = text.begin(); i != text.end(); ++i)
+    {
+        const wchar_t c = *i;
+        if (std::iswspace(c) || std::iswcntrl(c))
+        {
+            if (!out.empty() && out.back() != L' ')
+                out += L' ';
+        }
+        else
+        {
+            out += (wchar_t)std::towlower(c);
+        }
+    }
+}
+
+std::vector<std::wstring> FoldQuery(const wxString& query)
+{
+    std::wstring folded;
+    AppendFolded(folded, query);
+
+    std::vector<std::wstring> terms;
+    size_t start = 0;
+    while (start < folded.size())
+    {
+        size_t end = folded.find(L' ', start);
+        if (end == std::wstring::npos)
+            end = folded.size();
+        if (end > start)
+            terms.push_back(folded.substr(start, end - start));
+        start = end + 1;
+    }
+    return terms;
+}
+
+void FoldEntry(std::wstring& out, const CatalogItem& item)
+{
+    const size_t start = out.size();
+    AppendFolded(out, item.GetString());
+    if (item.HasContext())
+    {
+        out += L' ';
+        AppendFolded(out, item.GetContext());
+    }
+    for (auto& ref: item.GetReferences())
+    {
+        out += L' ';
+        AppendFolded(out, ref);
+    }
+    if (out.size() > start && out.back() == L' ')
+        out.pop_back();
+}
+
+// Is every term of the old query contained in some term of the new one?
+// If it is, anything that matches the new query matches the old one too.
+bool IsNarrowing(const std::vector<std::wstring>& oldTerms, const std::vector<std::wstring>& newTerms)
+{
+    auto isSubsequence = [](const std::wstring& needle, const std::wstring& haystack)
+    {
+        size_t n = 0;
+        for (size_t i = 0; i < haystack.size() && n < needle.size(); i++)
+        {
+            if (haystack[i] == needle[n])
+                n++;
+        }
+        return n == needle.size();
+    };
+
+    for (auto& o: oldTerms)
+    {
+        if (std::none_of(newTerms.begin(), newTerms.end(), [&](const std::wstring& n){ return isSubsequence(o, n); }))
+            return false;
+    }
+    return true;
+}
+
+
+enum class CharClass { NonWord, Word, Digit };
+
+inline CharClass ClassOf(wchar_t c)
+{
+    if (std::iswdigit(c))
+        return CharClass::Digit;
+    if (std::iswalnum(c))
+        return CharClass::Word;
+    return CharClass::NonWord;
+}
+
+inline int BonusFor(CharClass prev, CharClass cls)
+{
+    if (prev == CharClass::NonWord && cls != CharClass::NonWord)
+        return BONUS_BOUNDARY;
+    if (prev == CharClass::Word && cls == CharClass::Digit)
+        return BONUS_DIGIT;
+    if (cls == CharClass::NonWord)
+        return BONUS_NON_WORD;
+    return 0;
+}
+
+/**
+    Scores occurrence of @a term in text[begin,end) as a subsequence, or
+    returns -1 if it doesn't occur in it.
+
+    Like fzf's v1 algorithm, this finds the first occurrence, shrinks it
+    backwards to the shortest possible one and scores that.
+ */
+int ScoreTerm(const wchar_t *text, size_t begin, size_t end, const std::wstring& term)
+{
+    const size_t len = term.size();
+
+    size_t t = 0;
+    size_t matchEnd = end;
+    for (size_t i = begin; i < end; i++)
+    {
+        if (text[i] == term[t] && ++t == len)
+        {
+            matchEnd = i + 1;
+            break;
+        }
+    }
+    if (t < len)
+        return -1;
+
+    size_t matchStart = matchEnd - 1;
+    t = len;
+    for (size_t i = matchEnd; i-- > begin;)
+    {
+        if (text[i] == term[t - 1] && --t == 0)
+        {
+            matchStart = i;
+            break;
+        }
+    }
+
+    int score = 0;
+    int consecutive = 0;
+    int firstBonus = 0;
+    bool inGap = false;
+    CharClass prevClass = (matchStart > begin) ? ClassOf(text[matchStart - 1]) : CharClass::NonWord;
+
+    t = 0;
+    for (size_t i = matchStart; i < matchEnd; i++)
+    {
+        const wchar_t c = text[i];
+        const CharClass cls = ClassOf(c);
+        if (t < len && c == term[t])
+        {
+            score += SCORE_MATCH;
+            int bonus = BonusFor(prevClass, cls);
+            if (consecutive == 0)
+            {
+                firstBonus = bonus;
+            }
+            else
+            {
+                if (bonus == BONUS_BOUNDARY)
+                    firstBonus = bonus;
+                bonus = std::max({bonus, firstBonus, BONUS_CONSECUTIVE});
+            }
+            score += (t == 0) ? bonus * BONUS_FIRST_CHAR_MULTIPLIER : bonus;
+            inGap = false;
+            consecutive++;
+            t++;
+        }
+        else
+        {
+            score += inGap ? SCORE_GAP_EXTENSION : SCORE_GAP_START;
+            inGap = true;
+            consecutive = 0;
+            firstBonus = 0;
+        }
+        prevClass = cls;
+    }
+
+    return score;
+}
+
+struct ChunkResults
+{
+    std::vector<FuzzyEntryIndex::Match> matches;
+    std::vector<int> matching;
+};
+
+} // anonymous namespace
+
+
+FuzzyEntryIndex::FuzzyEntryIndex(const CatalogPtr& catalog)
+{
+    auto& items = catalog->items();
+
+    // Folding is done in parallel, into separate buffers that are then
+    // concatenated into the final one:
+    auto foldRange = [&items](size_t begin, size_t end)
+    {
+        std::pair<std::wstring, std::vector<uint32_t>> out;
+        out.second.reserve(end - begin);
+        for (size_t i = begin; i < end; i++)
+        {
+            FoldEntry(out.first, *items[i]);
+            out.second.push_back((uint32_t)out.first.size());
+        }
+        return out;
+    };
+
+    std::vector<std::pair<std::wstring, std::vector<uint32_t>>> parts;
+    if (items.size() < 2 * PARALLEL_CHUNK_SIZE)
+    {
+        parts.push_back(foldRange(0, items.size()));
+    }
+    else
+    {
+        std::vector<dispatch::future<std::pair<std::wstring, std::vector<uint32_t>>>> chunks;
+        for (size_t begin = 0; begin < items.size(); begin += PARALLEL_CHUNK_SIZE)
+        {
+            const size_t end = std::min(items.size(), begin + PARALLEL_CHUNK_SIZE);
+            chunks.push_back(dispatch::async([&foldRange, begin, end]{ return foldRange(begin, end); }));
+        }
+        for (auto& c: chunks)
+            parts.push_back(c.get());
+    }
+
+    size_t total = 0;
+    for (auto& p: parts)
+        total += p.first.size();
+    m_text.reserve(total);
+    m_offsets.reserve(items.size() + 1);
+    m_offsets.push_back(0);
+
+    for (auto& p: parts)
+    {
+        const uint32_t base = (uint32_t)m_text.size();
+        m_text += p.first;
+        for (auto o: p.second)
+            m_offsets.push_back(base + o);
+    }
+}
+
+
+FuzzyEntryIndex::Results FuzzyEntryIndex::Find(const wxString& query, size_t maxResults,
+                                               Deadline deadline, const Results *previous) const
+{
+    Results results;
+    results.terms = FoldQuery(query);
+    if (results.terms.empty())
+        return results;
+
+    // Only entries that matched the previous query can match if it was narrowed down:
+    const std::vector<int> *candidates = nullptr;
+    if (previous && previous->allMatching && IsNarrowing(previous->terms, results.terms))
+        candidates = previous->allMatching.get();
+
+    const size_t count = candidates ? candidates->size() : size();
+    std::atomic_bool timedOut(false);
+
+    auto searchRange = [&](size_t begin, size_t end)
+    {
+        ChunkResults out;
+        const wchar_t *text = m_text.data();
+        for (size_t n = begin; n < end; n++)
+        {
+            if ((n - begin) % DEADLINE_CHECK_INTERVAL == 0 &&
+                (timedOut || std::chrono::steady_clock::now() > deadline))
+            {
+                timedOut = true;
+                break;
+            }
+
+            const int index = candidates ? (*candidates)[n] : (int)n;
+            int score = 0;
+            for (auto& term: results.terms)
+            {
+                int s = ScoreTerm(text, m_offsets[index], m_offsets[index + 1], term);
+                if (s < 0)
+                {
+                    score = -1;
+                    break;
+                }
+                score += s;
+            }
+
+            if (score >= 0)
+            {
+                out.matches.push_back({index, score});
+                out.matching.push_back(index);
+            }
+        }
+        return out;
+    };
+
+    std::vector<ChunkResults> parts;
+    if (count < 2 * PARALLEL_CHUNK_SIZE)
+    {
+        parts.push_back(searchRange(0, count));
+    }
+    else
+    {
+        std::vector<dispatch::future<ChunkResults>> chunks;
+        for (size_t begin = 0; begin < count; begin += PARALLEL_CHUNK_SIZE)
+        {
+            const size_t end = std::min(count, begin + PARALLEL_CHUNK_SIZE);
+            chunks.push_back(dispatch::async([&searchRange, begin, end]{ return searchRange(begin, end); }));
+        }
+        for (auto& c: chunks)
+            parts.push_back(c.get());
+    }
+
+    auto allMatching = std::make_shared<std::vector<int>>();
+    for (auto& p: parts)
+    {
+        results.matches.insert(results.matches.end(), p.matches.begin(), p.matches.end());
+        allMatching->insert(allMatching->end(), p.matching.begin(), p.matching.end());
+    }
+
+    results.complete = !timedOut;
+    if (results.complete)
+        results.allMatching = allMatching;
+
+    // Prefer higher scores, then shorter entries, then document order:
+    auto better = [this](const Match& a, const Match& b)
+    {
+        if (a.score != b.score)
+            return a.score > b.score;
+        const auto lenA = m_offsets[a.index + 1] - m_offsets[a.index];
+        const auto lenB = m_offsets[b.index + 1] - m_offsets[b.index];
+        if (lenA != lenB)
+            return lenA < lenB;
+        return a.index < b.index;
+    };
+
+    if (results.matches.size() > maxResults)
+    {
+        std::partial_sort(results.matches.begin(), results.matches.begin() + maxResults, results.matches.end(), better);
+        results.matches.resize(maxResults);
+    }
+    else
+    {
+        std::sort(results.matches.begin(), results.matches.end(), better);
+    }
+
+    return results;
+}
+
+
+
+GoToEntryDialog::GoToEntryDialog(PoeditFrame *owner, const CatalogPtr& catalog)
+    : wxDialog(owner, wxID_ANY, _("Go to Entry"),
+               wxDefaultPosition, wxDefaultSize,
+               wxDEFAULT_DIALOG_STYLE | wxRESIZE_BORDER),
+      m_owner(owner),
+      m_catalog(catalog),
+      m_generation(0)
+{
+    auto sizer = new wxBoxSizer(wxVERTICAL);
+
+    m_query = new wxTextCtrl(this, wxID_ANY, "", wxDefaultPosition, wxDefaultSize, wxTE_PROCESS_ENTER);
+    m_query->SetHint(_("Source text, context or reference"));
+    sizer->Add(m_query, wxSizerFlags().Expand().PXDoubleBorderAll());
+
+    m_results = new wxListBox(this, wxID_ANY, wxDefaultPosition, wxSize(PX(600), PX(300)), 0, nullptr, wxLB_SINGLE);
+    sizer->Add(m_results, wxSizerFlags(1).Expand().PXDoubleBorder(wxLEFT|wxRIGHT|wxBOTTOM));
+
+    SetSizerAndFit(sizer);
+
+    m_query->Bind(wxEVT_TEXT, &GoToEntryDialog::OnText, this);
+    m_query->Bind(wxEVT_TEXT_ENTER, [=](wxCommandEvent&){ Activate(); });
+    m_query->Bind(wxEVT_KEY_DOWN, &GoToEntryDialog::OnKeyDown, this);
+    m_results->Bind(wxEVT_KEY_DOWN, &GoToEntryDialog::OnKeyDown, this);
+    m_results->Bind(wxEVT_LISTBOX_DCLICK, [=](wxCommandEvent&){ Activate(); });
+
+    // behave like a popup, not like a window to switch to:
+    Bind(wxEVT_ACTIVATE, [=](wxActivateEvent& e){
+        if (!e.GetActive())
+            Hide();
+        e.Skip();
+    });
+}
+
+
+void GoToEntryDialog::Reset(const CatalogPtr& catalog)
+{
+    m_catalog = catalog;
+    m_index.reset();
+    m_last = FuzzyEntryIndex::Results();
+    m_generation++;
+
+    if (IsShown())
+    {
+        m_index = std::make_shared<FuzzyEntryIndex>(m_catalog);
+        UpdateResults();
+    }
+}
+
+
+void GoToEntryDialog::ShowPalette()
+{
+    if (!m_index)
+    {
+        wxBusyCursor busy;
+        m_index = std::make_shared<FuzzyEntryIndex>(m_catalog);
+    }
+
+    m_query->ChangeValue("");
+    UpdateResults();
+
+    CentreOnParent(wxHORIZONTAL);
+    auto pos = GetPosition();
+    pos.y = m_owner->GetScreenPosition().y + PX(60);
+    SetPosition(pos);
+
+    Show();
+    Raise();
+    m_query->SetFocus();
+}
+
+
+void GoToEntryDialog::UpdateResults()
+{
+    m_generation++;
+
+    const wxString query = m_query->GetValue();
+    auto results = m_index->Find(query, MAX_RESULTS,
+                                 std::chrono::steady_clock::now() + TYPING_BUDGET,
+                                 &m_last);
+    ShowResults(results);
+
+    if (results.complete)
+        m_last = std::move(results);
+    else
+        CompleteSearchInBackground(query);
+}
+
+
+void GoToEntryDialog::CompleteSearchInBackground(const wxString& query)
+{
+    auto index = m_index;
+    auto previous = m_last;
+    const unsigned generation = m_generation;
+
+    dispatch::async([=]{
+        return index->Find(query, MAX_RESULTS, FuzzyEntryIndex::Deadline::max(), &previous);
+    })
+    .then_on_window(this, [=](FuzzyEntryIndex::Results results){
+        if (generation != m_generation)
+            return;  // the query changed in the meantime
+        ShowResults(results);
+        m_last = std::move(results);
+    })
+    .catch_all([](dispatch::exception_ptr){});
+}
+
+
+void GoToEntryDialog::ShowResults(const FuzzyEntryIndex::Results& results)
+{
+    wxArrayString labels;
+    m_shownIndexes.clear();
+
+    for (auto& m: results.matches)
+    {
+        auto item = (*m_catalog)[(unsigned)m.index];
+
+        wxString label = item->GetString();
+        label.Replace("\n", " ");
+        label.Replace("\t", " ");
+        if (label.length() > MAX_LABEL_LENGTH)
+        {
+            label.Truncate(MAX_LABEL_LENGTH);
+            label += L"…";
+        }
+        if (item->HasContext())
+            label += wxString::Format(L"  [%s]", item->GetContext());
+
+        labels.push_back(label);
+        m_shownIndexes.push_back(m.index);
+    }
+
+    m_results->Freeze();
+    m_results->Set(labels);
+    if (!labels.empty())
+        m_results->SetSelection(0);
+    m_results->Thaw();
+}
+
+
+void GoToEntryDialog::Activate()
+{
+    const int sel = m_results->GetSelection();
+    if (sel == wxNOT_FOUND || sel >= (int)m_shownIndexes.size())
+        return;
+
+    Hide();
+    m_owner->FocusCatalogItem(m_shownIndexes[sel]);
+}
+
+
+void GoToEntryDialog::OnText(wxCommandEvent&)
+{
+    UpdateResults();
+}
+
+
+void GoToEntryDialog::OnKeyDown(wxKeyEvent& event)
+{
+    const int count = (int)m_results->GetCount();
+    int sel = m_results->GetSelection();
+
+    switch (event.GetKeyCode())
+    {
+        case WXK_ESCAPE:
+            Hide();
+            return;
+
+        case WXK_UP:
+        case WXK_NUMPAD_UP:
+            if (sel > 0)
+                m_results->SetSelection(sel - 1);
+            return;
+
+        case WXK_DOWN:
+        case WXK_NUMPAD_DOWN:
+            if (sel + 1 < count)
+                m_results->SetSelection(sel + 1);
+            return;
+
+        case WXK_RETURN:
+        case WXK_NUMPAD_ENTER:
+            Activate();
+            return;
+
+        default:
+            event.Skip();
+            break;
+    }
+}
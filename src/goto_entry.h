@@ -0,0 +1,146 @@
+/*
+ *  This file is part of Poedit (https://poedit.net)
+ *
+ *  Copyright (C) 2020 Vaclav Slavik
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef Poedit_goto_entry_h
+#define Poedit_goto_entry_h
+
+#include "catalog.h"
+
+#include <wx/dialog.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class WXDLLIMPEXP_FWD_CORE wxListBox;
+class WXDLLIMPEXP_FWD_CORE wxTextCtrl;
+
+class PoeditFrame;
+
+
+/**
+    Index for fuzzy, fzf-style lookup of catalog entries.
+
+    Source text, context and references of all entries are case-folded
+    once, when the index is created, and stored in a single contiguous
+    buffer, so that queries don't need to touch the catalog items at all.
+
+    A query consists of whitespace-separated terms, each of which must match
+    as a subsequence of the entry's text, in any order. Matches are scored
+    by how compact they are and whether they start at word boundaries.
+ */
+class FuzzyEntryIndex
+{
+public:
+    explicit FuzzyEntryIndex(const CatalogPtr& catalog);
+
+    struct Match
+    {
+        /// Index of the item in the catalog
+        int index;
+        int score;
+    };
+
+    struct Results
+    {
+        /// Best matches, sorted by descending score
+        std::vector<Match> matches;
+        /// False if the time budget ran out before all entries were checked
+        bool complete = true;
+
+        /// Folded query terms the results are for
+        std::vector<std::wstring> terms;
+        /// All matching entries, in catalog order (only if complete)
+        std::shared_ptr<const std::vector<int>> allMatching;
+    };
+
+    typedef std::chrono::steady_clock::time_point Deadline;
+
+    /**
+        Finds up to @a maxResults best matches for @a query.
+
+        Searching stops when @a deadline is reached, in which case the
+        results only cover a part of the catalog and aren't complete.
+
+        If @a previous results are given and the query only extends their
+        query (as it does while the user is typing), only the entries that
+        matched previously are checked.
+
+        This method is thread-safe.
+     */
+    Results Find(const wxString& query, size_t maxResults,
+                 Deadline deadline = Deadline::max(),
+                 const Results *previous = nullptr) const;
+
+    size_t size() const { return m_offsets.size() - 1; }
+
+private:
+    std::wstring m_text;
+    std::vector<uint32_t> m_offsets;
+};
+
+
+/**
+    Quick "Go to Entry" palette.
+
+    Shows best fuzzy matches (see FuzzyEntryIndex) as the user types and
+    selects the chosen entry in the owner window.
+ */
+class GoToEntryDialog : public wxDialog
+{
+public:
+    GoToEntryDialog(PoeditFrame *owner, const CatalogPtr& catalog);
+
+    /// Changes the catalog in use, e.g. after it was reloaded.
+    void Reset(const CatalogPtr& catalog);
+
+    /// Shows the palette with empty query.
+    void ShowPalette();
+
+private:
+    void UpdateResults();
+    void ShowResults(const FuzzyEntryIndex::Results& results);
+    void CompleteSearchInBackground(const wxString& query);
+    void Activate();
+
+    void OnText(wxCommandEvent& event);
+    void OnKeyDown(wxKeyEvent& event);
+
+    PoeditFrame *m_owner;
+    wxTextCtrl *m_query;
+    wxListBox *m_results;
+
+    CatalogPtr m_catalog;
+    std::shared_ptr<FuzzyEntryIndex> m_index;
+    // last complete results, used to narrow down the next search
+    FuzzyEntryIndex::Results m_last;
+    std::vector<int> m_shownIndexes;
+    // incremented on every change, to discard stale background searches
+    unsigned m_generation;
+};
+
+#endif // Poedit_goto_entry_h
@@ -135,6 +135,28 @@ public:
     /// Perform a GET request at the given URL
     dispatch::future<json> get(const std::string& url);
 
+    /// Response to a conditional GET request
+    struct conditional_response
+    {
+        /// Server reported the resource as unchanged; @a data is empty then
+        bool not_modified = false;
+        /// Parsed JSON body of the response
+        json data;
+        /// Validators to use for the next request (may be empty)
+        std::string etag, last_modified;
+    };
+
+    /**
+        Perform a conditional GET request at the given URL.
+
+        @a etag and @a last_modified are validators from a previous response
+        (either may be empty). If the server responds with 304 Not Modified,
+        the result has @a not_modified set and carries the same validators.
+     */
+    dispatch::future<conditional_response> get_conditional(const std::string& url,
+                                                           const std::string& etag,
+                                                           const std::string& last_modified);
+
     /**
         Perform a GET request and store the body in a file.
         
@@ -167,6 +167,47 @@ public:
         });
     }
 
+    dispatch::future<http_client::conditional_response> get_conditional(const std::string& url,
+                                                                         const std::string& etag,
+                                                                         const std::string& last_modified)
+    {
+        http::http_request req(http::methods::GET);
+        req.headers().add(http::header_names::accept,     L"application/json");
+        req.headers().add(http::header_names::user_agent, m_userAgent);
+        req.headers().add(http::header_names::accept_language, ui_language);
+        if (!m_auth.empty())
+            req.headers().add(http::header_names::authorization, m_auth);
+        if (!etag.empty())
+            req.headers().add(http::header_names::if_none_match, to_string_t(etag));
+        if (!last_modified.empty())
+            req.headers().add(http::header_names::if_modified_since, to_string_t(last_modified));
+        req.set_request_uri(to_string_t(url));
+
+        return
+        m_native.request(req)
+        .then([=](http::http_response response)
+        {
+            http_client::conditional_response r;
+            if (response.status_code() == http::status_codes::NotModified)
+            {
+                r.not_modified = true;
+                r.etag = etag;
+                r.last_modified = last_modified;
+                return r;
+            }
+
+            handle_error(response);
+            r.data = ::json::parse(response.extract_utf8string().get());
+
+            string_t value;
+            if (response.headers().match(http::header_names::etag, value))
+                r.etag = utility::conversions::to_utf8string(value);
+            if (response.headers().match(http::header_names::last_modified, value))
+                r.last_modified = utility::conversions::to_utf8string(value);
+            return r;
+        });
+    }
+
     dispatch::future<void> download(const std::string& url, const std::wstring& output_file)
     {
         using namespace concurrency::streams;
@@ -310,6 +351,13 @@ dispatch::future<::json> http_client::get(const std::string& url)
     return m_impl->get(url);
 }
 
+dispatch::future<http_client::conditional_response> http_client::get_conditional(const std::string& url,
+                                                                                 const std::string& etag,
+                                                                                 const std::string& last_modified)
+{
+    return m_impl->get_conditional(url, etag, last_modified);
+}
+
 dispatch::future<void> http_client::download(const std::string& url, const std::wstring& output_file)
 {
     return m_impl->download(url, output_file);
@@ -96,6 +96,51 @@ public:
         return promise->get_future();
     }
 
+    dispatch::future<http_client::conditional_response> get_conditional(const std::string& url,
+                                                                         const std::string& etag,
+                                                                         const std::string& last_modified)
+    {
+        auto promise = std::make_shared<dispatch::promise<http_client::conditional_response>>();
+
+        auto request = build_request(@"GET", url);
+        // bypass NSURLCache, it would otherwise transparently turn 304 into 200:
+        request.cachePolicy = NSURLRequestReloadIgnoringLocalCacheData;
+        if (!etag.empty())
+            [request setValue:str::to_NS(etag) forHTTPHeaderField:@"If-None-Match"];
+        if (!last_modified.empty())
+            [request setValue:str::to_NS(last_modified) forHTTPHeaderField:@"If-Modified-Since"];
+
+        auto task = [m_session dataTaskWithRequest:request completionHandler:^(NSData *data, NSURLResponse *response, NSError *error) {
+            try
+            {
+                http_client::conditional_response r;
+                NSHTTPURLResponse *httpResponse = (NSHTTPURLResponse*)response;
+                if (error == nil && httpResponse && httpResponse.statusCode == 304)
+                {
+                    r.not_modified = true;
+                    r.etag = etag;
+                    r.last_modified = last_modified;
+                    promise->set_value(r);
+                    return;
+                }
+
+                if (handle_error(data, response, error, *promise))
+                    return;
+                r.data = extract_json(data);
+                r.etag = header_value(httpResponse, @"ETag");
+                r.last_modified = header_value(httpResponse, @"Last-Modified");
+                promise->set_value(r);
+            }
+            catch (...)
+            {
+                dispatch::set_current_exception(promise);
+            }
+        }];
+        [task resume];
+
+        return promise->get_future();
+    }
+
     dispatch::future<void> download(const std::string& url, const std::wstring& output_file)
     {
         auto promise = std::make_shared<dispatch::promise<void>>();
@@ -207,6 +252,18 @@ private:
         return true;
     }
 
+    static std::string header_value(NSHTTPURLResponse *response, NSString *name)
+    {
+        // allHeaderFields is case-sensitive, but HTTP header names aren't:
+        NSDictionary *headers = response.allHeaderFields;
+        for (NSString *key in headers)
+        {
+            if ([key caseInsensitiveCompare:name] == NSOrderedSame)
+                return str::to_utf8((NSString*)headers[key]);
+        }
+        return std::string();
+    }
+
     json extract_json(NSData *data)
     {
         return json::parse(std::string((char*)data.bytes, data.length));
@@ -240,6 +297,13 @@ dispatch::future<json> http_client::get(const std::string& url)
     return m_impl->get(url);
 }
 
+dispatch::future<http_client::conditional_response> http_client::get_conditional(const std::string& url,
+                                                                                 const std::string& etag,
+                                                                                 const std::string& last_modified)
+{
+    return m_impl->get_conditional(url, etag, last_modified);
+}
+
 dispatch::future<void> http_client::download(const std::string& url, const std::wstring& output_file)
 {
     return m_impl->download(url, output_file);
@@ -23,6 +23,7 @@
  *
  */
 
+#include <wx/accel.h>
 #include <wx/imaglist.h>
 #include <wx/config.h>
 #include <wx/textctrl.h>
@@ -38,6 +39,7 @@
 #include <wx/msgdlg.h>
 #include <wx/button.h>
 #include <wx/dir.h>
+#include <wx/filename.h>
 #include <wx/imaglist.h>
 #include <wx/dirdlg.h>
 #include <wx/log.h>
@@ -51,12 +53,16 @@
 #endif
 
 #include "catalog.h"
+#include "catalog_xliff.h"
 #include "cat_update.h"
+#include "compression.h"
 #include "edapp.h"
 #include "edframe.h"
 #include "hidpi.h"
 #include "manager.h"
 #include "progressinfo.h"
+#include "project_search.h"
+#include "text_statistics.h"
 #include "utility.h"
 
 
@@ -91,7 +97,11 @@ ManagerFrame::ManagerFrame() :
     ms_instance = this;
 
     auto tb = wxXmlResource::Get()->LoadToolBar(this, "manager_toolbar");
-    (void)tb;
+    tb->AddSeparator();
+    tb->AddTool(XRCID("prj_find"), _("Find in Project"),
+                wxArtProvider::GetBitmap(wxART_FIND, wxART_TOOLBAR),
+                _("Search all catalogs in the project"));
+    tb->Realize();
 #ifdef __WXMSW__
     // De-uglify the toolbar a bit on Windows 10:
     if (IsWindows10OrGreater())
@@ -125,6 +135,12 @@ ManagerFrame::ManagerFrame() :
     if (m_listPrj->GetCount() > 0)
         UpdateListCat(last);
 
+    wxAcceleratorEntry entries[] = {
+        { wxACCEL_CMD | wxACCEL_SHIFT, 'F', XRCID("prj_find") }
+    };
+    wxAcceleratorTable accel(WXSIZEOF(entries), entries);
+    SetAcceleratorTable(accel);
+
     RestoreWindowState(this, wxSize(PX(400), PX(300)));
 
     m_splitter->SetSashPosition((int)wxConfig::Get()->Read("manager_splitter", PX(200)));
@@ -179,10 +195,60 @@ void ManagerFrame::UpdateListPrj(int select)
 }
 
 
+wxArrayString ManagerFrame::GetAllProjectsDirs()
+{
+    wxConfigBase *cfg = wxConfig::Get();
+    long max = cfg->Read("Manager/max_project_num", (long)0) + 1;
+    wxString key;
+
+    wxArrayString all;
+    for (int i = 0; i <= max; i++)
+    {
+        key.Printf("Manager/project_%i/", i);
+        if (cfg->Read(key + "Name", wxEmptyString).empty())
+            continue;
+        wxStringTokenizer tkn(cfg->Read(key + "Dirs", wxEmptyString), wxPATH_SEP);
+        while (tkn.HasMoreTokens())
+            all.push_back(tkn.GetNextToken());
+    }
+    return all;
+}
+
+
+void ManagerFrame::FindCatalogsInDir(const wxString& dir, wxArrayString& catalogs)
+{
+    for (auto mask: {"*.po", "*.xlf", "*.xliff", "*.po.gz", "*.xlf.gz", "*.xliff.gz"})
+        wxDir::GetAllFiles(dir, &catalogs, mask, wxDIR_FILES | wxDIR_DIRS);
+}
+
+
+// Gathers statistics of a XLIFF file without loading it into memory whole
+static void GetXLIFFStatistics(const wxString& file, int *all, int *fuzzy, int *untranslated,
+                               int *words, int *remainingWords)
+{
+    XLIFFStreamReader reader(file);
+    reader.ForEachUnit([=](const XLIFFStreamReader::Unit& u)
+    {
+        int w, chars;
+        CountWordsAndChars(u.source, u.srcLang, w, chars);
+
+        (*all)++;
+        *words += w;
+        if (u.isFuzzy)
+            (*fuzzy)++;
+        if (!u.isTranslated)
+            (*untranslated)++;
+        if (!u.isTranslated || u.isFuzzy)
+            *remainingWords += w;
+    });
+}
+
+
 static void AddCatalogToList(wxListCtrl *list, int i, int id, const wxString& file)
 {
     wxConfigBase *cfg = wxConfig::Get();
     int all = 0, fuzzy = 0, untranslated = 0, badtokens = 0;
+    int words = 0, remainingWords = 0;
     wxString lastmodified;
     time_t modtime;
     wxString key;
@@ -194,12 +260,15 @@ static void AddCatalogToList(wxListCtrl *list, int i, int id, const wxString& fi
 
     modtime = cfg->Read(key + "timestamp", (long)0);
 
-    if (modtime == wxFileModificationTime(file))
+    // note: entries cached by older versions don't have word counts
+    if (modtime == wxFileModificationTime(file) && cfg->HasEntry(key + "words"))
     {
         all = (int)cfg->Read(key + "all", (long)0);
         fuzzy = (int)cfg->Read(key + "fuzzy", (long)0);
         badtokens = (int)cfg->Read(key + "badtokens", (long)0);
         untranslated = (int)cfg->Read(key + "untranslated", (long)0);
+        words = (int)cfg->Read(key + "words", (long)0);
+        remainingWords = (int)cfg->Read(key + "remaining_words", (long)0);
         lastmodified = cfg->Read(key + "lastmodified", "?");
     }
     else
@@ -208,19 +277,47 @@ static void AddCatalogToList(wxListCtrl *list, int i, int id, const wxString& fi
         // FIXME: *do* indicate error somehow
         wxLogNull nullLog;
 
+        wxString ext;
+        wxFileName::SplitPath(StripGzipExtension(file), nullptr, nullptr, nullptr, &ext);
+        const bool isXLIFF = XLIFFCatalog::CanLoadFile(ext.Lower());
+
         // FIXME: don't re-load the catalog if it's already loaded in the
         //        editor, reuse loaded instance
-        auto cat = Catalog::Create(file);
-        if (cat)
+        auto cat = isXLIFF ? CatalogPtr() : Catalog::Create(file);
+        if (cat || isXLIFF)
         {
-            cat->GetStatistics(&all, &fuzzy, &badtokens, &untranslated, NULL);
+            if (isXLIFF)
+            {
+                try
+                {
+                    GetXLIFFStatistics(file, &all, &fuzzy, &untranslated, &words, &remainingWords);
+                }
+                catch (...)
+                {
+                    // malformed file: show it in the list, but flagged as unreadable
+                    // and not cached, so that it is re-read once it's fixed
+                    list->InsertItem(i, file, 0);
+                    list->SetItem(i, 1, "?");
+                    list->SetItem(i, 7, _("Unreadable file"));
+                    return;
+                }
+            }
+            else
+            {
+                cat->GetStatistics(&all, &fuzzy, &badtokens, &untranslated, NULL);
+                auto wordStats = GetWordStatistics(cat);
+                words = wordStats.sourceWords;
+                remainingWords = wordStats.remainingWords;
+                lastmodified = cat->Header().RevisionDate;
+            }
             modtime = wxFileModificationTime(file);
-            lastmodified = cat->Header().RevisionDate;
             cfg->Write(key + "timestamp", (long)modtime);
             cfg->Write(key + "all", (long)all);
             cfg->Write(key + "fuzzy", (long)fuzzy);
             cfg->Write(key + "badtokens", (long)badtokens);
             cfg->Write(key + "untranslated", (long)untranslated);
+            cfg->Write(key + "words", (long)words);
+            cfg->Write(key + "remaining_words", (long)remainingWords);
             cfg->Write(key + "lastmodified", lastmodified);
         }
     }
@@ -242,7 +339,11 @@ static void AddCatalogToList(wxListCtrl *list, int i, int id, const wxString& fi
     list->SetItem(i, 3, tmp);
     tmp.Printf("%i", badtokens);
     list->SetItem(i, 4, tmp);
-    list->SetItem(i, 5, lastmodified);
+    tmp.Printf("%i", words);
+    list->SetItem(i, 5, tmp);
+    tmp.Printf("%i", remainingWords);
+    list->SetItem(i, 6, tmp);
+    list->SetItem(i, 7, lastmodified);
 }
 
 void ManagerFrame::UpdateListCat(int id)
@@ -260,8 +361,7 @@ void ManagerFrame::UpdateListCat(int id)
 
     m_catalogs.Clear();
     while (tkn.HasMoreTokens())
-        wxDir::GetAllFiles(tkn.GetNextToken(), &m_catalogs,
-                           "*.po", wxDIR_FILES | wxDIR_DIRS);
+        FindCatalogsInDir(tkn.GetNextToken(), m_catalogs);
 
     m_catalogs.Sort();
 
@@ -273,7 +373,9 @@ void ManagerFrame::UpdateListCat(int id)
     m_listCat->InsertColumn(2, _("Untrans"));
     m_listCat->InsertColumn(3, _("Needs Work"));
     m_listCat->InsertColumn(4, _("Errors"));
-    m_listCat->InsertColumn(5, _("Last modified"));
+    m_listCat->InsertColumn(5, _("Words"));
+    m_listCat->InsertColumn(6, _("Remaining Words"));
+    m_listCat->InsertColumn(7, _("Last modified"));
 
     // FIXME: this is time-consuming, it should be done in parallel on
     //        multi-core/SMP systems
@@ -285,7 +387,9 @@ void ManagerFrame::UpdateListCat(int id)
     m_listCat->SetColumnWidth(2, wxLIST_AUTOSIZE_USEHEADER);
     m_listCat->SetColumnWidth(3, wxLIST_AUTOSIZE_USEHEADER);
     m_listCat->SetColumnWidth(4, wxLIST_AUTOSIZE_USEHEADER);
-    m_listCat->SetColumnWidth(5, wxLIST_AUTOSIZE);
+    m_listCat->SetColumnWidth(5, wxLIST_AUTOSIZE_USEHEADER);
+    m_listCat->SetColumnWidth(6, wxLIST_AUTOSIZE_USEHEADER);
+    m_listCat->SetColumnWidth(7, wxLIST_AUTOSIZE);
 
     m_listCat->Thaw();
 }
@@ -390,6 +494,7 @@ BEGIN_EVENT_TABLE(ManagerFrame, wxFrame)
    EVT_MENU                 (XRCID("prj_edit"),   ManagerFrame::OnEditProject)
    EVT_MENU                 (XRCID("prj_delete"), ManagerFrame::OnDeleteProject)
    EVT_MENU                 (XRCID("prj_update"), ManagerFrame::OnUpdateProject)
+   EVT_MENU                 (XRCID("prj_find"),   ManagerFrame::OnFindInProject)
    EVT_LISTBOX              (XRCID("prj_list"),   ManagerFrame::OnSelectProject)
    EVT_LIST_ITEM_ACTIVATED  (XRCID("prj_files"),  ManagerFrame::OnOpenCatalog)
    EVT_MENU                 (wxID_CLOSE,          ManagerFrame::OnCloseCmd)
@@ -449,6 +554,9 @@ void ManagerFrame::OnSelectProject(wxCommandEvent&)
     if (sel == -1) return;
     m_curPrj = (int)(wxIntPtr)m_listPrj->GetClientData(sel);
     UpdateListCat(m_curPrj);
+
+    if (m_searchFrame)
+        m_searchFrame->SetProject(m_listPrj->GetString(sel), m_catalogs);
 }
 
 
@@ -476,6 +584,13 @@ void ManagerFrame::OnUpdateProject(wxCommandEvent&)
             }
             else
             {
+                // only PO files can be updated from sources; XLIFF files are
+                // listed for their statistics only and must be left alone
+                wxString ext;
+                wxFileName::SplitPath(StripGzipExtension(f), nullptr, nullptr, nullptr, &ext);
+                if (!POCatalog::CanLoadFile(ext.Lower()))
+                    continue;
+
                 auto cat = std::make_shared<POCatalog>(f);
                 UpdateResultReason reason;
                 if (PerformUpdateFromSources(this, cat, reason, Update_DontShowSummary))
@@ -492,6 +607,21 @@ void ManagerFrame::OnUpdateProject(wxCommandEvent&)
 }
 
 
+void ManagerFrame::OnFindInProject(wxCommandEvent&)
+{
+    int sel = m_listPrj->GetSelection();
+    if (sel == -1) return;
+
+    if (!m_searchFrame)
+    {
+        m_searchFrame = new ProjectSearchFrame(this);
+        m_searchFrame->SetProject(m_listPrj->GetString(sel), m_catalogs);
+    }
+    m_searchFrame->Show();
+    m_searchFrame->Raise();
+}
+
+
 void ManagerFrame::OnOpenCatalog(wxListEvent& event)
 {
     PoeditFrame *f = PoeditFrame::Create(m_catalogs[event.GetIndex()]);
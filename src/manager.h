@@ -28,12 +28,14 @@
 
 #include <wx/frame.h>
 #include <wx/string.h>
+#include <wx/weakref.h>
 
 class WXDLLIMPEXP_FWD_CORE wxListCtrl;
 class WXDLLIMPEXP_FWD_CORE wxListBox;
 class WXDLLIMPEXP_FWD_CORE wxSplitterWindow;
 
 class Catalog;
+class ProjectSearchFrame;
 
 /** ManagerFrame provides a convenient way to manage PO catalogs.
     The frame contains two lists: a list of projects and list of catalogs
@@ -54,6 +56,12 @@ class ManagerFrame : public wxFrame
          */
         void NotifyFileChanged(const wxString& catalog);
 
+        /// Returns directories of all projects; must be called on the main thread.
+        static wxArrayString GetAllProjectsDirs();
+
+        /// Finds all catalogs in @a dir and its subdirectories.
+        static void FindCatalogsInDir(const wxString& dir, wxArrayString& catalogs);
+
     private:
         ManagerFrame();
         ~ManagerFrame();
@@ -77,6 +85,7 @@ class ManagerFrame : public wxFrame
         void OnEditProject(wxCommandEvent& event);
         void OnDeleteProject(wxCommandEvent& event);
         void OnUpdateProject(wxCommandEvent& event);
+        void OnFindInProject(wxCommandEvent& event);
         void OnSelectProject(wxCommandEvent& event);
         void OnOpenCatalog(wxListEvent& event);
         void OnCloseCmd(wxCommandEvent& event);
@@ -86,6 +95,7 @@ class ManagerFrame : public wxFrame
         wxSplitterWindow *m_splitter;
         wxArrayString m_catalogs;
         int m_curPrj;
+        wxWeakRef<ProjectSearchFrame> m_searchFrame;
 
         static ManagerFrame *ms_instance;
 };
@@ -51,6 +51,7 @@
 #include <wx/progdlg.h>
 #include <wx/xrc/xmlres.h>
 #include <wx/numformatter.h>
+#include <wx/weakref.h>
 
 #if !wxCHECK_VERSION(3,1,0)
     #define CenterVertical() Center()
@@ -59,15 +60,19 @@
 #include "edapp.h"
 #include "edframe.h"
 #include "catalog.h"
+#include "catalog_xliff.h"
+#include "compression.h"
 #include "configuration.h"
 #include "crowdin_gui.h"
 #include "hidpi.h"
+#include "tm/retention.h"
 #include "tm/transmem.h"
 #include "tm/tmx_io.h"
 #include "chooselang.h"
 #include "errors.h"
 #include "extractors/extractor_legacy.h"
 #include "spellchecking.h"
+#include "str_helpers.h"
 #include "utility.h"
 #include "customcontrols.h"
 #include "unicode_helpers.h"
@@ -356,6 +361,94 @@ public:
 
 
 
+/// Dialog for editing the TM retention policy and applying it
+class TMRetentionDialog : public wxDialog
+{
+public:
+    TMRetentionDialog(wxWindow *parent)
+        : wxDialog(parent, wxID_ANY, _("Clean Up Translation Memory"))
+    {
+        auto topsizer = new wxBoxSizer(wxVERTICAL);
+        auto sizer = new wxBoxSizer(wxVERTICAL);
+        topsizer->Add(sizer, wxSizerFlags(1).Expand().PXDoubleBorderAll());
+
+        m_useMaxAge = new wxCheckBox(this, wxID_ANY, _("Remove translations older than"));
+        m_maxAge = new wxSpinCtrl(this, wxID_ANY, "", wxDefaultPosition, wxSize(PX(80),-1), wxSP_ARROW_KEYS, 1, 36500, 730);
+        auto ageSizer = new wxBoxSizer(wxHORIZONTAL);
+        ageSizer->Add(m_useMaxAge, wxSizerFlags().Center());
+        ageSizer->AddSpacer(PX(5));
+        ageSizer->Add(m_maxAge, wxSizerFlags().Center());
+        ageSizer->AddSpacer(PX(5));
+        // TRANSLATORS: Preceded by "Remove translations older than <number>"
+        ageSizer->Add(new wxStaticText(this, wxID_ANY, _("days")), wxSizerFlags().Center());
+        sizer->Add(ageSizer, wxSizerFlags().PXBorder(wxTOP|wxBOTTOM));
+
+        m_useMaxEntries = new wxCheckBox(this, wxID_ANY, _("Keep at most"));
+        m_maxEntries = new wxSpinCtrl(this, wxID_ANY, "", wxDefaultPosition, wxSize(PX(100),-1), wxSP_ARROW_KEYS, 100, 10000000, 100000);
+        auto entriesSizer = new wxBoxSizer(wxHORIZONTAL);
+        entriesSizer->Add(m_useMaxEntries, wxSizerFlags().Center());
+        entriesSizer->AddSpacer(PX(5));
+        entriesSizer->Add(m_maxEntries, wxSizerFlags().Center());
+        entriesSizer->AddSpacer(PX(5));
+        // TRANSLATORS: Preceded by "Keep at most <number>"
+        entriesSizer->Add(new wxStaticText(this, wxID_ANY, _("newest translations per language")), wxSizerFlags().Center());
+        sizer->Add(entriesSizer, wxSizerFlags().PXBorder(wxTOP|wxBOTTOM));
+
+        m_removeUnused = new wxCheckBox(this, wxID_ANY, _("Remove translations of texts not used in any Catalogs Manager project"));
+        sizer->Add(m_removeUnused, wxSizerFlags().PXBorder(wxTOP));
+        sizer->Add(new ExplanationLabel(this, _(L"Warning: this removes everything that isn’t in your projects’ files right now, including translations imported from TMX files and other translation files.")),
+                   wxSizerFlags().Expand().Border(wxLEFT, PX(ExplanationLabel::CHECKBOX_INDENT)));
+
+        sizer->AddSpacer(PX(5));
+        sizer->Add(new ExplanationLabel(this, _(L"These rules are also applied automatically, once a week, in the background. Removed translations can’t be restored.")),
+                   wxSizerFlags().Expand());
+
+        auto buttons = CreateButtonSizer(wxOK | wxCANCEL);
+        topsizer->Add(buttons, wxSizerFlags().Expand().PXDoubleBorder(wxLEFT|wxRIGHT|wxBOTTOM));
+        SetSizerAndFit(topsizer);
+
+        const long maxAge = Config::TMMaxAgeDays();
+        const long maxEntries = Config::TMMaxEntriesPerLanguage();
+        m_useMaxAge->SetValue(maxAge > 0);
+        if (maxAge > 0)
+            m_maxAge->SetValue((int)maxAge);
+        m_useMaxEntries->SetValue(maxEntries > 0);
+        if (maxEntries > 0)
+            m_maxEntries->SetValue((int)maxEntries);
+        m_removeUnused->SetValue(Config::TMRemoveUnused());
+
+        m_removeUnused->Bind(wxEVT_CHECKBOX, [=](wxCommandEvent& e)
+        {
+            if (!e.IsChecked())
+                return;
+            // this rule is destructive enough to require explicit confirmation:
+            wxMessageDialog dlg(this,
+                                _("Remove all translations not used in your projects?"),
+                                _("Clean Up Translation Memory"),
+                                wxYES_NO | wxNO_DEFAULT | wxICON_WARNING);
+            dlg.SetExtendedMessage(_(L"Translations imported from TMX files or other translation files, and translations of files that aren’t in any Catalogs Manager project, will be permanently removed from the translation memory whenever the clean up runs."));
+            dlg.SetYesNoLabels(_("Remove Unused"), _("Cancel"));
+            if (dlg.ShowModal() != wxID_YES)
+                m_removeUnused->SetValue(false);
+        });
+        m_maxAge->Bind(wxEVT_UPDATE_UI, [=](wxUpdateUIEvent& e){ e.Enable(m_useMaxAge->GetValue()); });
+        m_maxEntries->Bind(wxEVT_UPDATE_UI, [=](wxUpdateUIEvent& e){ e.Enable(m_useMaxEntries->GetValue()); });
+    }
+
+    /// Stores the policy in the configuration
+    void SavePolicy()
+    {
+        Config::TMMaxAgeDays(m_useMaxAge->GetValue() ? m_maxAge->GetValue() : 0);
+        Config::TMMaxEntriesPerLanguage(m_useMaxEntries->GetValue() ? m_maxEntries->GetValue() : 0);
+        Config::TMRemoveUnused(m_removeUnused->GetValue());
+    }
+
+private:
+    wxCheckBox *m_useMaxAge, *m_useMaxEntries, *m_removeUnused;
+    wxSpinCtrl *m_maxAge, *m_maxEntries;
+};
+
+
 class TMPageWindow : public PrefsPanel
 {
 public:
@@ -412,6 +505,12 @@ public:
         sizer->Add(learnMore, wxSizerFlags().Border(wxLEFT, PX(ExplanationLabel::CHECKBOX_INDENT + LearnMoreLink::EXTRA_INDENT)));
         sizer->AddSpacer(PX(10));
 
+        m_sentences = new wxCheckBox(this, wxID_ANY, _("Match long texts sentence by sentence"));
+        sizer->Add(m_sentences, wxSizerFlags().PXBorder(wxTOP|wxBOTTOM));
+        auto explainSentences = new ExplanationLabel(this, _(L"Sentences of multi-sentence translations are remembered individually as well, so that a paragraph that changed only slightly can still be translated from the TM."));
+        sizer->Add(explainSentences, wxSizerFlags().Expand().Border(wxLEFT, PX(ExplanationLabel::CHECKBOX_INDENT)));
+        sizer->AddSpacer(PX(10));
+
 #ifdef __WXOSX__
         m_stats->SetWindowVariant(wxWINDOW_VARIANT_SMALL);
         manage->SetWindowVariant(wxWINDOW_VARIANT_SMALL);
@@ -420,6 +519,7 @@ public:
         m_mergeBehavior->Bind(wxEVT_UPDATE_UI, [=](wxUpdateUIEvent& e){ e.Enable(m_mergeUse->GetValue() == true); });
 
         m_stats->Bind(wxEVT_UPDATE_UI, &TMPageWindow::OnUpdateUI, this);
+        m_sentences->Bind(wxEVT_UPDATE_UI, &TMPageWindow::OnUpdateUI, this);
         manage->Bind(wxEVT_UPDATE_UI, &TMPageWindow::OnUpdateUI, this);
 
         manage->Bind(wxEVT_BUTTON, &TMPageWindow::OnManageTM, this);
@@ -430,6 +530,7 @@ public:
         {
             m_mergeUse->Bind(wxEVT_CHECKBOX, [=](wxCommandEvent&){ TransferDataFromWindow(); });
             m_mergeBehavior->Bind(wxEVT_CHOICE, [=](wxCommandEvent&){ TransferDataFromWindow(); });
+            m_sentences->Bind(wxEVT_CHECKBOX, [=](wxCommandEvent&){ TransferDataFromWindow(); });
             // Some settings directly affect the UI, so need a more expensive handler:
             m_useTM->Bind(wxEVT_CHECKBOX, &TMPageWindow::TransferDataFromWindowAndUpdateUI, this);
         }
@@ -441,11 +542,13 @@ public:
         auto merge = Config::MergeBehavior();
         m_mergeUse->SetValue(merge != Merge_None);
         m_mergeBehavior->SetSelection(merge == Merge_UseTM ? 1 : 0);
+        m_sentences->SetValue(Config::TMSentenceSegments());
     }
 
     void SaveValues(wxConfigBase&) override
     {
         Config::UseTM(m_useTM->GetValue());
+        Config::TMSentenceSegments(m_sentences->GetValue());
         if (m_mergeUse->GetValue() == true)
         {
             Config::MergeBehavior(m_mergeBehavior->GetSelection() == 1 ? Merge_UseTM : Merge_FuzzyMatch);
@@ -488,6 +591,7 @@ private:
         static const auto idLearn = wxNewId();
         static const auto idImportTMX = wxNewId();
         static const auto idExportTMX = wxNewId();
+        static const auto idCleanUp = wxNewId();
         static const auto idReset = wxNewId();
 
         wxMenu *menu = new wxMenu();
@@ -499,12 +603,14 @@ private:
         menu->Append(idImportTMX, MSW_OR_OTHER(_(L"Import from TMX…"), _(L"Import From TMX…")));
         menu->Append(idExportTMX, MSW_OR_OTHER(_(L"Export to TMX…"), _(L"Export To TMX…")));
         menu->AppendSeparator();
+        menu->Append(idCleanUp, MSW_OR_OTHER(_(L"Clean up…"), _(L"Clean Up…")));
         // TRANSLATORS: This is a button that deletes everything in the translation memory (i.e. clears/resets it).
         menu->Append(idReset, _("Reset"));
 
         menu->Bind(wxEVT_MENU, &TMPageWindow::OnImportIntoTM, this, idLearn);
         menu->Bind(wxEVT_MENU, &TMPageWindow::OnImportTMX, this, idImportTMX);
         menu->Bind(wxEVT_MENU, &TMPageWindow::OnExportTMX, this, idExportTMX);
+        menu->Bind(wxEVT_MENU, &TMPageWindow::OnCleanUpTM, this, idCleanUp);
         menu->Bind(wxEVT_MENU, &TMPageWindow::OnResetTM, this, idReset);
 
         auto win = dynamic_cast<wxButton*>(e.GetEventObject());
@@ -538,20 +644,51 @@ private:
                                       this,
                                       wxPD_APP_MODAL|wxPD_AUTO_HIDE|wxPD_CAN_ABORT);
             auto tm = TranslationMemory::Get().GetWriter();
+            TranslationMemory::InsertStats stats;
             int step = 0;
             for (size_t i = 0; i < paths.size(); i++)
             {
+                wxString ext;
+                wxFileName::SplitPath(StripGzipExtension(paths[i]), nullptr, nullptr, nullptr, &ext);
+                if (XLIFFCatalog::CanLoadFile(ext.Lower()))
+                {
+                    // XLIFF files can be huge, so don't load them into memory whole
+                    if (!progress.Update(++step))
+                        break;
+                    try
+                    {
+                        XLIFFStreamReader reader(paths[i]);
+                        reader.ForEachUnit([&tm,&stats](const XLIFFStreamReader::Unit& u)
+                        {
+                            if (!u.isTranslated || u.isFuzzy || !u.srcLang.IsValid() || !u.lang.IsValid())
+                                return;
+                            stats += tm->Insert(u.srcLang, u.lang, str::to_wstring(u.source), str::to_wstring(u.translation));
+                        });
+                    }
+                    catch (const XLIFFReadException& e)
+                    {
+                        // malformed file: report it and import the rest, same as
+                        // with unreadable PO files (entries read so far are kept)
+                        wxLogError("%s", e.What());
+                    }
+                    if (!progress.Update(++step))
+                        break;
+                    continue;
+                }
+
                 auto cat = Catalog::Create(paths[i]);
                 if (!progress.Update(++step))
                     break;
                 if (cat && cat->IsOk())
-                    tm->Insert(cat);
+                    stats += tm->Insert(cat);
                 if (!progress.Update(++step))
                     break;
             }
             progress.Pulse(_(L"Finalizing…"));
             tm->Commit();
             UpdateStats();
+            progress.Hide();
+            ReportImportResults(stats);
         });
     }
 
@@ -580,13 +717,15 @@ private:
                                       this,
                                       wxPD_APP_MODAL|wxPD_AUTO_HIDE|wxPD_CAN_ABORT);
             progress.Pulse();
+            TranslationMemory::InsertStats stats;
+            bool ok = true;
             for (auto p: paths)
             {
                 try
                 {
                     std::ifstream f;
                     f.open(p.fn_str());
-                    TMX::ImportFromFile(f, TranslationMemory::Get());
+                    stats += TMX::ImportFromFile(f, TranslationMemory::Get());
                     f.close();
 
                     if (!progress.Pulse())
@@ -603,13 +742,38 @@ private:
                         ));
                     err->SetExtendedMessage(DescribeCurrentException());
                     err->ShowWindowModalThenDo([err](int){});
+                    ok = false;
                     break;
                 }
             }
             UpdateStats();
+            if (ok)
+            {
+                progress.Hide();
+                ReportImportResults(stats);
+            }
         });
     }
 
+    void ReportImportResults(const TranslationMemory::InsertStats& stats)
+    {
+        wxWindowPtr<wxMessageDialog> info(new wxMessageDialog
+        (
+            this,
+            _("Translations were imported into the translation memory."),
+            _("Translation Memory"),
+            wxOK | wxICON_INFORMATION
+        ));
+        info->SetExtendedMessage(wxString::Format
+        (
+            "%s\n%s\n%s",
+            wxString::Format(_("New translations: %s"), wxNumberFormatter::ToString(stats.added)),
+            wxString::Format(_("Updated translations: %s"), wxNumberFormatter::ToString(stats.updated)),
+            wxString::Format(_("Already stored, skipped: %s"), wxNumberFormatter::ToString(stats.skipped))
+        ));
+        info->ShowWindowModalThenDo([info](int){});
+    }
+
     void OnExportTMX(wxCommandEvent&)
     {
         wxWindowPtr<wxFileDialog> dlg(new wxFileDialog
@@ -656,6 +820,46 @@ private:
         });
     }
 
+    void OnCleanUpTM(wxCommandEvent&)
+    {
+        wxWindowPtr<TMRetentionDialog> dlg(new TMRetentionDialog(this));
+
+        dlg->ShowWindowModalThenDo([=](int retcode){
+            if (retcode != wxID_OK)
+                return;
+
+            dlg->SavePolicy();
+            if (!TMRetention::IsEnabled())
+                return;
+
+            m_stats->SetLabel(_(L"Cleaning up translation memory…"));
+            wxWeakRef<TMPageWindow> self(this);
+
+            TMRetention::PruneAsync()
+            .then_on_window(this, [=](TranslationMemory::PruneReport report)
+            {
+                UpdateStats();
+                wxWindowPtr<wxMessageDialog> info(new wxMessageDialog
+                (
+                    this,
+                    _("Translation memory was cleaned up."),
+                    _("Translation Memory"),
+                    wxOK | wxICON_INFORMATION
+                ));
+                info->SetExtendedMessage(TMRetention::DescribeReport(report));
+                info->ShowWindowModalThenDo([info](int){});
+            })
+            .catch_all([self](dispatch::exception_ptr e)
+            {
+                dispatch::on_main([=]{
+                    if (self)
+                        self->UpdateStats();
+                    wxLogError(_("Cleaning up translation memory failed: %s"), DescribeException(e));
+                });
+            });
+        });
+    }
+
     void OnResetTM(wxCommandEvent&)
     {
         auto title = _("Reset translation memory");
@@ -683,6 +887,7 @@ private:
     wxCheckBox *m_useTM;
     wxCheckBox *m_mergeUse;
     wxChoice *m_mergeBehavior;
+    wxCheckBox *m_sentences;
     wxStaticText *m_stats;
 };
 
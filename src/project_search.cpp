@@ -0,0 +1,361 @@
+/*
+ *  This file is part of Poedit (https://poedit.net)
+ *
+ *  Copyright (C) 2020 Vaclav Slavik
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "project_search.h"
+
+#include "catalog_po.h"
+#include "catalog_xliff.h"
+#include "compression.h"
+#include "concurrency.h"
+#include "edframe.h"
+#include "hidpi.h"
+#include "utility.h"
+
+#include <wx/accel.h>
+#include <wx/filename.h>
+#include <wx/log.h>
+#include <wx/panel.h>
+#include <wx/sizer.h>
+#include <wx/srchctrl.h>
+#include <wx/stattext.h>
+#include <wx/treectrl.h>
+
+namespace
+{
+
+// Don't flood the results tree with too many hits for overly generic queries
+const size_t MAX_HITS_PER_FILE = 500;
+
+// Maximum length of text shown in the results tree
+const size_t MAX_HIT_TEXT_LENGTH = 100;
+
+class HitData : public wxTreeItemData
+{
+public:
+    HitData(const ProjectSearchFrame::Hit& h) : hit(h) {}
+    ProjectSearchFrame::Hit hit;
+};
+
+wxString FormatHitText(const wxString& text)
+{
+    wxString s(text);
+    s.Replace("\n", " ");
+    s.Replace("\t", " ");
+    if (s.length() > MAX_HIT_TEXT_LENGTH)
+    {
+        s.Truncate(MAX_HIT_TEXT_LENGTH);
+        s += L"…";
+    }
+    return s;
+}
+
+inline bool Matches(const wxString& text, const wxString& lowercaseNeedle)
+{
+    return !text.empty() && text.Lower().find(lowercaseNeedle) != wxString::npos;
+}
+
+ProjectSearchFrame::Hit MakeHit(const wxString& file, int index, unsigned lineNumber,
+                                const wxString& source, const wxString& translation)
+{
+    ProjectSearchFrame::Hit h;
+    h.file = file;
+    h.index = index;
+    h.lineNumber = lineNumber;
+    h.source = source;
+    h.translation = translation;
+    return h;
+}
+
+// Searches a single file, runs on a background thread.
+std::vector<ProjectSearchFrame::Hit> SearchFile(const wxString& file,
+                                                const wxString& lowercaseNeedle,
+                                                std::shared_ptr<std::atomic_bool> cancelled)
+{
+    std::vector<ProjectSearchFrame::Hit> hits;
+    if (*cancelled)
+        return hits;
+
+    // suppress error messages, we don't mind if some catalog is corrupted
+    wxLogNull nullLog;
+
+    wxString ext;
+    wxFileName::SplitPath(StripGzipExtension(file), nullptr, nullptr, nullptr, &ext);
+
+    int index = 0;
+    if (XLIFFCatalog::CanLoadFile(ext.Lower()))
+    {
+        try
+        {
+            XLIFFStreamReader reader(file);
+            reader.ForEachUnit([&](const XLIFFStreamReader::Unit& u)
+            {
+                const int i = index++;
+                if (*cancelled || hits.size() >= MAX_HITS_PER_FILE)
+                    return;
+                if (Matches(u.source, lowercaseNeedle) || Matches(u.translation, lowercaseNeedle))
+                    hits.push_back(MakeHit(file, i, 0, u.source, u.translation));
+            });
+        }
+        catch (...)
+        {
+            // corrupted file, report whatever was found before the error
+        }
+    }
+    else
+    {
+        POStreamReader reader(file);
+        reader.ForEachEntry([&](const POStreamReader::Entry& e)
+        {
+            const int i = index++;
+            if (*cancelled)
+                return false;
+
+            bool found = Matches(e.source, lowercaseNeedle) || Matches(e.sourcePlural, lowercaseNeedle);
+            for (size_t t = 0; !found && t < e.translations.size(); t++)
+                found = Matches(e.translations[t], lowercaseNeedle);
+
+            if (found)
+            {
+                hits.push_back(MakeHit(file, i, e.lineNumber, e.source,
+                                       e.translations.empty() ? wxString() : e.translations[0]));
+            }
+            return hits.size() < MAX_HITS_PER_FILE;
+        });
+    }
+
+    return hits;
+}
+
+} // anonymous namespace
+
+
+ProjectSearchFrame::ProjectSearchFrame(wxWindow *parent)
+    : wxFrame(parent, wxID_ANY, _("Find in Project"),
+              wxDefaultPosition, wxDefaultSize,
+              wxDEFAULT_FRAME_STYLE | wxFRAME_FLOAT_ON_PARENT,
+              "project_search"),
+      m_pendingFiles(0), m_hitsCount(0), m_filesWithHits(0)
+{
+    auto panel = new wxPanel(this, wxID_ANY);
+    auto sizer = new wxBoxSizer(wxVERTICAL);
+
+    m_searchField = new wxSearchCtrl(panel, wxID_ANY, "", wxDefaultPosition, wxDefaultSize, wxTE_PROCESS_ENTER);
+    m_searchField->ShowCancelButton(true);
+    m_searchField->SetDescriptiveText(_("Search source texts and translations"));
+    sizer->Add(m_searchField, wxSizerFlags().Expand().PXDoubleBorderAll());
+
+    m_results = new wxTreeCtrl(panel, wxID_ANY, wxDefaultPosition, wxDefaultSize,
+                               wxTR_DEFAULT_STYLE | wxTR_HIDE_ROOT | wxTR_SINGLE | wxTR_LINES_AT_ROOT);
+    m_results->AddRoot(wxString());
+    sizer->Add(m_results, wxSizerFlags(1).Expand().PXDoubleBorder(wxLEFT|wxRIGHT));
+
+    m_status = new wxStaticText(panel, wxID_ANY, "");
+    sizer->Add(m_status, wxSizerFlags().Expand().PXDoubleBorderAll());
+
+    panel->SetSizer(sizer);
+    auto topsizer = new wxBoxSizer(wxHORIZONTAL);
+    topsizer->Add(panel, wxSizerFlags(1).Expand());
+    SetSizer(topsizer);
+
+    RestoreWindowState(this, wxSize(PX(600), PX(400)));
+
+    wxAcceleratorEntry entries[] = {
+#ifdef __WXOSX__
+        { wxACCEL_CMD, 'W', wxID_CLOSE },
+#endif
+        { wxACCEL_NORMAL, WXK_ESCAPE, wxID_CLOSE }
+    };
+    wxAcceleratorTable accel(WXSIZEOF(entries), entries);
+    SetAcceleratorTable(accel);
+
+    m_searchField->Bind(wxEVT_TEXT_ENTER, &ProjectSearchFrame::OnSearch, this);
+    m_searchField->Bind(wxEVT_SEARCHCTRL_SEARCH_BTN, &ProjectSearchFrame::OnSearch, this);
+    m_searchField->Bind(wxEVT_SEARCHCTRL_CANCEL_BTN, [=](wxCommandEvent&){
+        m_searchField->Clear();
+        StartSearch();
+    });
+    m_results->Bind(wxEVT_TREE_ITEM_ACTIVATED, &ProjectSearchFrame::OnActivated, this);
+    Bind(wxEVT_MENU, &ProjectSearchFrame::OnClose, this, wxID_CLOSE);
+
+    m_searchField->SetFocus();
+}
+
+
+ProjectSearchFrame::~ProjectSearchFrame()
+{
+    CancelSearch();
+    SaveWindowState(this);
+}
+
+
+void ProjectSearchFrame::SetProject(const wxString& name, const wxArrayString& files)
+{
+    SetTitle(wxString::Format(L"%s — %s", _("Find in Project"), name));
+
+    m_files = files;
+    StartSearch();
+}
+
+
+void ProjectSearchFrame::CancelSearch()
+{
+    if (m_cancelled)
+        *m_cancelled = true;
+    m_cancelled.reset();
+    m_pendingFiles = 0;
+}
+
+
+void ProjectSearchFrame::StartSearch()
+{
+    CancelSearch();
+
+    m_results->DeleteChildren(m_results->GetRootItem());
+    m_hitsCount = m_filesWithHits = 0;
+
+    const wxString needle = m_searchField->GetValue().Lower();
+    if (needle.empty() || m_files.empty())
+    {
+        UpdateStatus();
+        return;
+    }
+
+    auto cancelled = std::make_shared<std::atomic_bool>(false);
+    m_cancelled = cancelled;
+    m_pendingFiles = m_files.size();
+    UpdateStatus();
+
+    // Every file is searched as a separate task, so that they are processed
+    // in parallel and the results of each are shown as soon as it's done:
+    for (auto& f: m_files)
+    {
+        const wxString file(f);
+        dispatch::async([=]{
+            return SearchFile(file, needle, cancelled);
+        })
+        .then_on_window(this, [=](std::vector<Hit> hits){
+            if (*cancelled)
+                return;  // results of an older search
+            OnFileSearched(file, std::move(hits));
+        })
+        .catch_all([](dispatch::exception_ptr){});
+    }
+}
+
+
+void ProjectSearchFrame::OnFileSearched(const wxString& file, std::vector<Hit> hits)
+{
+    if (m_pendingFiles > 0)
+        m_pendingFiles--;
+
+    if (!hits.empty())
+    {
+        m_hitsCount += hits.size();
+        m_filesWithHits++;
+
+        m_results->Freeze();
+
+        auto root = m_results->GetRootItem();
+        auto fileItem = m_results->AppendItem(root, wxString::Format("%s (%d)", file, (int)hits.size()));
+        m_results->SetItemBold(fileItem);
+
+        for (auto& h: hits)
+        {
+            wxString label = FormatHitText(h.source);
+            if (!h.translation.empty())
+                label += L"  →  " + FormatHitText(h.translation);
+            m_results->AppendItem(fileItem, label, -1, -1, new HitData(h));
+        }
+
+        m_results->Expand(fileItem);
+        m_results->SortChildren(root);
+
+        m_results->Thaw();
+    }
+
+    UpdateStatus();
+}
+
+
+void ProjectSearchFrame::UpdateStatus()
+{
+    wxString status;
+    if (m_hitsCount == 0 && m_pendingFiles == 0)
+    {
+        if (!m_searchField->GetValue().empty())
+            status = _("No matches found.");
+    }
+    else
+    {
+        status = wxString::Format(wxPLURAL("%d match", "%d matches", (int)m_hitsCount), (int)m_hitsCount);
+        status += " ";
+        status += wxString::Format(wxPLURAL("in %d file", "in %d files", (int)m_filesWithHits), (int)m_filesWithHits);
+    }
+
+    if (m_pendingFiles > 0)
+    {
+        if (!status.empty())
+            status += L" — ";
+        status += wxString::Format(wxPLURAL(L"searching %d more file…", L"searching %d more files…", (int)m_pendingFiles), (int)m_pendingFiles);
+    }
+
+    m_status->SetLabel(status);
+}
+
+
+void ProjectSearchFrame::OnSearch(wxCommandEvent&)
+{
+    StartSearch();
+}
+
+
+void ProjectSearchFrame::OnActivated(wxTreeEvent& event)
+{
+    auto item = event.GetItem();
+    auto data = dynamic_cast<HitData*>(m_results->GetItemData(item));
+    if (!data)
+    {
+        // file node
+        m_results->Toggle(item);
+        return;
+    }
+
+    const Hit hit = data->hit;
+
+    // PO entries are located by line number, which is robust against changes
+    // to the file since it was searched, but XLIFF items don't have them:
+    PoeditFrame *f = PoeditFrame::Create(hit.file, (int)hit.lineNumber);
+    if (!f)
+        return;
+    if (hit.lineNumber == 0)
+        f->FocusCatalogItem(hit.index);
+    f->Raise();
+}
+
+
+void ProjectSearchFrame::OnClose(wxCommandEvent&)
+{
+    Close();
+}
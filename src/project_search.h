@@ -0,0 +1,91 @@
+/*
+ *  This file is part of Poedit (https://poedit.net)
+ *
+ *  Copyright (C) 2020 Vaclav Slavik
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef Poedit_project_search_h
+#define Poedit_project_search_h
+
+#include <wx/arrstr.h>
+#include <wx/frame.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class WXDLLIMPEXP_FWD_CORE wxSearchCtrl;
+class WXDLLIMPEXP_FWD_CORE wxStaticText;
+class WXDLLIMPEXP_FWD_CORE wxTreeCtrl;
+class WXDLLIMPEXP_FWD_CORE wxTreeEvent;
+
+
+/**
+    Window for searching all catalogs of a Catalogs Manager project at once.
+
+    Files are scanned in parallel in the background, without loading them
+    into full Catalog instances, and hits are shown, grouped by file, as
+    soon as each file is done. Activating a hit opens the catalog at it.
+ */
+class ProjectSearchFrame : public wxFrame
+{
+public:
+    ProjectSearchFrame(wxWindow *parent);
+    ~ProjectSearchFrame();
+
+    /// Sets the project to search in; restarts the search if there's one.
+    void SetProject(const wxString& name, const wxArrayString& files);
+
+    /// One matching entry
+    struct Hit
+    {
+        wxString file;
+        /// Index of the item in the catalog, in document order
+        int index = -1;
+        /// Line number of the entry (only for PO files, 0 otherwise)
+        unsigned lineNumber = 0;
+        wxString source, translation;
+    };
+
+private:
+    void StartSearch();
+    void CancelSearch();
+    void OnFileSearched(const wxString& file, std::vector<Hit> hits);
+    void UpdateStatus();
+
+    void OnSearch(wxCommandEvent& event);
+    void OnActivated(wxTreeEvent& event);
+    void OnClose(wxCommandEvent& event);
+
+    wxSearchCtrl *m_searchField;
+    wxTreeCtrl *m_results;
+    wxStaticText *m_status;
+
+    wxArrayString m_files;
+
+    // flag shared with the background tasks of the current search
+    std::shared_ptr<std::atomic_bool> m_cancelled;
+    size_t m_pendingFiles;
+    size_t m_hitsCount, m_filesWithHits;
+};
+
+#endif // Poedit_project_search_h
@@ -25,10 +25,27 @@
 
 #include "qa_checks.h"
 
+#include "concurrency.h"
+#include "utility.h"
+
 #include <unicode/uchar.h>
 
+#include <wx/dcscreen.h>
+#include <wx/filename.h>
+#include <wx/log.h>
+#include <wx/settings.h>
+#include <wx/thread.h>
 #include <wx/translation.h>
 
+#include <cstdint>
+#include <cstring>
+#include <cwchar>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
 
 // -------------------------------------------------------------
 // QACheck implementations
@@ -303,6 +320,151 @@ private:
 };
 
 
+/**
+    Estimates rendered width of texts from cached advances of their glyphs.
+
+    Measuring every text with a DC would be too slow for large catalogs, and
+    it's only possible on the main thread anyway. Instead, glyphs are measured
+    on the main thread once per font, and widths of texts are just sums of
+    their advances. This ignores kerning and ligatures, but that's good enough
+    for a warning.
+ */
+class GlyphWidthCache
+{
+public:
+    /// Returns the cache for given font; must be called on the main thread.
+    static GlyphWidthCache& For(const wxFont& font)
+    {
+        static std::map<wxString, std::unique_ptr<GlyphWidthCache>> s_caches;
+        auto& c = s_caches[font.GetNativeFontInfoDesc()];
+        if (!c)
+            c.reset(new GlyphWidthCache(font));
+        return *c;
+    }
+
+    /// Measures all glyphs of @a text not measured yet; main thread only.
+    void Measure(const wxString& text)
+    {
+        std::unique_ptr<wxScreenDC> dc;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto c: text)
+        {
+            const wxChar ch = c;
+            if (ch == '\n' || m_advances.find(ch) != m_advances.end())
+                continue;
+            if (!dc)
+            {
+                dc.reset(new wxScreenDC);
+                dc->SetFont(m_font);
+            }
+            m_advances.emplace(ch, dc->GetTextExtent(wxString(ch)).x);
+        }
+    }
+
+    /// Returns width of the widest line of @a text, or -1 if not all of its glyphs are known.
+    int EstimateWidth(const wxString& text) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        int width = 0, lineWidth = 0;
+        for (auto c: text)
+        {
+            const wxChar ch = c;
+            if (ch == '\n')
+            {
+                lineWidth = 0;
+                continue;
+            }
+            auto i = m_advances.find(ch);
+            if (i == m_advances.end())
+                return -1;
+            lineWidth += i->second;
+            width = std::max(width, lineWidth);
+        }
+        return width;
+    }
+
+private:
+    GlyphWidthCache(const wxFont& font) : m_font(font) {}
+
+    wxFont m_font;
+    mutable std::mutex m_mutex;
+    std::unordered_map<wxChar, int> m_advances;
+};
+
+
+class WidthLimit : public QACheck
+{
+public:
+    WidthLimit() : m_glyphs(nullptr) {}
+
+    void Prepare(const std::vector<CatalogItemPtr>& items) override
+    {
+        // glyphs can only be measured on the main thread; checks done
+        // elsewhere use only what was measured before
+        if (!wxThread::IsMain())
+            return;
+
+        for (auto& item: items)
+        {
+            if (!GetLimit(*item))
+                continue;
+            if (!m_glyphs)
+                m_glyphs = &GlyphWidthCache::For(wxSystemSettings::GetFont(wxSYS_DEFAULT_GUI_FONT));
+            for (auto& t: item->GetTranslations())
+                m_glyphs->Measure(t);
+        }
+    }
+
+    bool CheckString(CatalogItemPtr item, const wxString& /*source*/, const wxString& translation) override
+    {
+        if (!m_glyphs)
+            return false;
+
+        const int limit = GetLimit(*item);
+        if (!limit)
+            return false;
+
+        const int width = m_glyphs->EstimateWidth(translation);
+        if (width > limit)
+        {
+            item->SetIssue(CatalogItem::Issue::Warning,
+                           wxString::Format(_("The translation is too wide: about %dpx, but only %dpx are available."), width, limit));
+            return true;
+        }
+
+        return false;
+    }
+
+private:
+    // Returns max. width of the translation in pixels, or 0 if not limited.
+    // The limit is set with "max-width:NNN" flag or "max-width: NNNpx" extracted
+    // comment (as e.g. xgettext's --add-comments would extract it from the code).
+    static int GetLimit(const CatalogItem& item)
+    {
+        int limit = ParseLimit(item.GetFlags());
+        for (auto& c: item.GetExtractedComments())
+        {
+            if (limit)
+                break;
+            limit = ParseLimit(c);
+        }
+        return limit;
+    }
+
+    static int ParseLimit(const wxString& s)
+    {
+        static const wxString marker("max-width:");
+        auto pos = s.find(marker);
+        if (pos == wxString::npos)
+            return 0;
+        const long limit = std::wcstol(s.wc_str() + pos + marker.length(), nullptr, 10);
+        return limit > 0 ? (int)limit : 0;
+    }
+
+    GlyphWidthCache *m_glyphs;
+};
+
+
 } // namespace QA
 
 
@@ -337,25 +499,343 @@ bool QACheck::CheckString(CatalogItemPtr /*item*/, const wxString& /*source*/, c
 }
 
 
+// -------------------------------------------------------------
+// QAResultsCache
+// -------------------------------------------------------------
+
+namespace
+{
+
+// Increment whenever behavior of any check changes, to discard cached results
+const uint32_t QA_CHECKS_VERSION = 2;
+
+// Minimal number of items to check on a single background thread
+const size_t PARALLEL_CHUNK_SIZE = 1000;
+
+const char QA_CACHE_MAGIC[8] = {'P','o','e','d','i','t','Q','A'};
+const uint32_t QA_CACHE_FORMAT = 1;
+const size_t QA_CACHE_MAX_SIZE = 256 * 1024 * 1024;
+// Limit of total size of all QA caches, least recently used are deleted
+const uint64_t QA_CACHE_MAX_TOTAL_SIZE = 256 * 1024 * 1024;
+
+using ::fnv1a;
+
+inline uint64_t fnv1a(const wxString& s, uint64_t hash)
+{
+    const auto utf8 = s.utf8_str();
+    // include the terminating NUL as a separator of consecutive fields:
+    return fnv1a(utf8.data(), utf8.length() + 1, hash);
+}
+
+
+/**
+    Persistent cache of QA results for a single catalog file.
+
+    Results are keyed by hash of item's content that affects QA checks and
+    stored in user's cache directory, so that only changed items need to be
+    checked again when the file is opened next time. Anything wrong with the
+    cache file (missing, corrupted, created by different version of checks
+    or for different language) simply means it's not used.
+ */
+class QAResultsCache
+{
+public:
+    struct Result
+    {
+        int issues;
+        std::shared_ptr<CatalogItem::Issue> issue;
+    };
+
+    QAResultsCache(const wxString& catalogFile, const std::string& context)
+        : m_context(context), m_modified(false)
+    {
+        const auto path = MakeFileName(catalogFile).GetFullPath();
+        m_filename = wxString::Format("%s%c%016llx.qacache",
+                                      GetCacheDir("QA"), wxFILE_SEP_PATH,
+                                      (unsigned long long)fnv1a(path, 0));
+        if (Load())
+        {
+            // mark as recently used, for TrimCacheDir():
+            wxLogNull null;
+            wxFileName(m_filename).Touch();
+        }
+        else
+        {
+            m_cached.clear();
+        }
+    }
+
+    static uint64_t KeyFor(const CatalogItem& item)
+    {
+        uint64_t hash = fnv1a(item.GetString(), 0);
+        hash = fnv1a(item.HasPlural() ? item.GetPluralString() : wxString(), hash);
+        hash = fnv1a(item.GetFlags(), hash);
+        for (auto& c: item.GetExtractedComments())
+            hash = fnv1a(c, hash);
+        for (auto& t: item.GetTranslations())
+            hash = fnv1a(t, hash);
+        return hash;
+    }
+
+    const Result *Find(uint64_t key)
+    {
+        auto i = m_cached.find(key);
+        if (i == m_cached.end())
+            return nullptr;
+        // remember it as still used:
+        return &(m_current[key] = i->second);
+    }
+
+    void Add(uint64_t key, Result&& r)
+    {
+        m_current[key] = std::move(r);
+        m_modified = true;
+    }
+
+    void Save()
+    {
+        // entries of changed or removed items should be dropped, too:
+        if (!m_modified && m_current.size() == m_cached.size())
+            return;
+
+        std::string data(QA_CACHE_MAGIC, sizeof(QA_CACHE_MAGIC));
+        Write(data, QA_CACHE_FORMAT);
+        WriteString(data, m_context);
+        Write(data, (uint32_t)m_current.size());
+        for (auto& i: m_current)
+        {
+            Write(data, i.first);
+            Write(data, (int32_t)i.second.issues);
+            Write(data, (uint8_t)(i.second.issue ? 1 : 0));
+            if (i.second.issue)
+            {
+                Write(data, (uint8_t)i.second.issue->severity);
+                WriteString(data, i.second.issue->message.utf8_str().data());
+            }
+        }
+        Write(data, fnv1a(data.data(), data.size()));
+
+        wxLogNull null;  // failure to write the cache isn't a problem for the user
+        TempOutputFileFor tempfile(m_filename);
+        {
+            std::ofstream f(tempfile.FileName().fn_str(), std::ios::out | std::ios::binary);
+            f.write(data.data(), data.size());
+            if (!f)
+                return;
+        }
+        tempfile.Commit();
+
+        TrimCacheDir(wxFileName(m_filename).GetPath(), "*.qacache", QA_CACHE_MAX_TOTAL_SIZE);
+    }
+
+private:
+    template<typename T>
+    static void Write(std::string& data, T value)
+    {
+        data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    static void WriteString(std::string& data, const std::string& s)
+    {
+        Write(data, (uint32_t)s.size());
+        data.append(s);
+    }
+
+    // Bounds-checked reading of the serialized data
+    struct Reader
+    {
+        const std::string& data;
+        size_t pos;
+
+        template<typename T>
+        bool Read(T& value)
+        {
+            if (data.size() - pos < sizeof(T))
+                return false;
+            memcpy(&value, data.data() + pos, sizeof(T));
+            pos += sizeof(T);
+            return true;
+        }
+
+        bool ReadString(std::string& s)
+        {
+            uint32_t len;
+            if (!Read(len) || data.size() - pos < len)
+                return false;
+            s.assign(data, pos, len);
+            pos += len;
+            return true;
+        }
+    };
+
+    bool Load()
+    {
+        if (!wxFileName::FileExists(m_filename))
+            return false;
+
+        std::string data;
+        {
+            std::ifstream f(m_filename.fn_str(), std::ios::in | std::ios::binary);
+            if (!f)
+                return false;
+            std::ostringstream s;
+            s << f.rdbuf();
+            data = s.str();
+        }
+
+        if (data.size() < sizeof(QA_CACHE_MAGIC) + sizeof(uint64_t) || data.size() > QA_CACHE_MAX_SIZE)
+            return false;
+        if (memcmp(data.data(), QA_CACHE_MAGIC, sizeof(QA_CACHE_MAGIC)) != 0)
+            return false;
+
+        uint64_t checksum;
+        const size_t payloadSize = data.size() - sizeof(checksum);
+        memcpy(&checksum, data.data() + payloadSize, sizeof(checksum));
+        if (checksum != fnv1a(data.data(), payloadSize))
+            return false;
+        data.resize(payloadSize);
+
+        Reader r {data, sizeof(QA_CACHE_MAGIC)};
+        uint32_t format, count;
+        std::string context;
+        if (!r.Read(format) || format != QA_CACHE_FORMAT)
+            return false;
+        if (!r.ReadString(context) || context != m_context)
+            return false;
+        if (!r.Read(count))
+            return false;
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint64_t key;
+            int32_t issues;
+            uint8_t hasIssue;
+            if (!r.Read(key) || !r.Read(issues) || !r.Read(hasIssue))
+                return false;
+
+            Result res {issues, nullptr};
+            if (hasIssue)
+            {
+                uint8_t severity;
+                std::string message;
+                if (!r.Read(severity) || !r.ReadString(message))
+                    return false;
+                if (severity != CatalogItem::Issue::Warning && severity != CatalogItem::Issue::Error)
+                    return false;
+                res.issue = std::make_shared<CatalogItem::Issue>((CatalogItem::Issue::Severity)severity,
+                                                                 wxString::FromUTF8(message.c_str()));
+            }
+            m_cached.emplace(key, std::move(res));
+        }
+
+        return r.pos == data.size();
+    }
+
+private:
+    wxString m_filename;
+    std::string m_context;
+    std::unordered_map<uint64_t, Result> m_cached, m_current;
+    bool m_modified;
+};
+
+} // anonymous namespace
+
+
 // -------------------------------------------------------------
 // QAChecker
 // -------------------------------------------------------------
 
 int QAChecker::Check(Catalog& catalog)
 {
-    // TODO: parallelize this (make async tasks for chunks of the catalog)
-    //       doing it per-checker is MT-unsafe with API that calls SetIssue()!
+    std::unique_ptr<QAResultsCache> cache;
+    const auto filename = catalog.GetFileName();
+    if (!m_cacheContext.empty() && !filename.empty())
+    {
+        // issues' messages are localized, so cached ones are only valid for the same UI language:
+        std::string context = m_cacheContext;
+        context += ";version=" + std::to_string(QA_CHECKS_VERSION);
+        if (auto trans = wxTranslations::Get())
+            context += ";ui=" + trans->GetBestTranslation("poedit").ToStdString();
+
+        cache.reset(new QAResultsCache(filename, context));
+    }
 
     int issues = 0;
 
+    std::vector<CatalogItemPtr> stale;
+    std::vector<uint64_t> staleKeys;
     for (auto& i: catalog.items())
-        issues += Check(i);
+    {
+        if (cache)
+        {
+            const auto key = QAResultsCache::KeyFor(*i);
+            if (auto cached = cache->Find(key))
+            {
+                if (cached->issue)
+                    i->SetIssue(cached->issue);
+                issues += cached->issues;
+                continue;
+            }
+            staleKeys.push_back(key);
+        }
+        stale.push_back(i);
+    }
+
+    for (auto& c: m_checks)
+        c->Prepare(stale);
+
+    // Checks only modify the item they check, so different items can be
+    // checked in parallel:
+    std::vector<int> found(stale.size(), 0);
+    if (stale.size() < 2 * PARALLEL_CHUNK_SIZE)
+    {
+        for (size_t i = 0; i < stale.size(); i++)
+            found[i] = DoCheck(stale[i]);
+    }
+    else
+    {
+        std::vector<dispatch::future<void>> chunks;
+        for (size_t begin = 0; begin < stale.size(); begin += PARALLEL_CHUNK_SIZE)
+        {
+            const size_t end = std::min(stale.size(), begin + PARALLEL_CHUNK_SIZE);
+            chunks.push_back(dispatch::async([=,&stale,&found]{
+                for (size_t i = begin; i < end; i++)
+                    found[i] = DoCheck(stale[i]);
+            }));
+        }
+        for (auto& c: chunks)
+            c.get();
+    }
+
+    for (size_t i = 0; i < stale.size(); i++)
+    {
+        issues += found[i];
+        if (cache)
+        {
+            std::shared_ptr<CatalogItem::Issue> issue;
+            if (found[i] && stale[i]->HasIssue())
+                issue = std::make_shared<CatalogItem::Issue>(stale[i]->GetIssue());
+            cache->Add(staleKeys[i], {found[i], issue});
+        }
+    }
+
+    if (cache)
+        cache->Save();
 
     return issues;
 }
 
 
 int QAChecker::Check(CatalogItemPtr item)
+{
+    for (auto& c: m_checks)
+        c->Prepare({item});
+
+    return DoCheck(item);
+}
+
+
+int QAChecker::DoCheck(CatalogItemPtr item)
 {
     int issues = 0;
 
@@ -380,5 +860,10 @@ std::shared_ptr<QAChecker> QAChecker::GetFor(Catalog& catalog)
     c->AddCheck<QA::CaseMismatch>(lang);
     c->AddCheck<QA::WhitespaceMismatch>();
     c->AddCheck<QA::PunctuationMismatch>(lang);
+    c->AddCheck<QA::WidthLimit>();
+    c->m_cacheContext = "lang=" + lang.Code();
+    // width checks' results depend on the UI font, which is only known on the main thread:
+    if (wxThread::IsMain())
+        c->m_cacheContext += ";font=" + wxSystemSettings::GetFont(wxSYS_DEFAULT_GUI_FONT).GetNativeFontInfoDesc().ToStdString();
     return c;
 }
@@ -29,6 +29,7 @@
 #include "catalog.h"
 
 #include <memory>
+#include <string>
 #include <vector>
 
 
@@ -49,6 +50,13 @@ public:
 
     /// A more convenient API, checking only strings
     virtual bool CheckString(CatalogItemPtr item, const wxString& source, const wxString& translation);
+
+    /**
+        Called on the calling thread before @a items are checked. Checks may
+        run in parallel afterwards, so this is the place to do any work that
+        must be done on the main thread (e.g. using the GUI API).
+     */
+    virtual void Prepare(const std::vector<CatalogItemPtr>& /*items*/) {}
 };
 
 
@@ -59,7 +67,12 @@ public:
     /// Returns checker suitable for given file
     static std::shared_ptr<QAChecker> GetFor(Catalog& catalog);
 
-    /// Checks all items. Returns # of issues found.
+    /**
+        Checks all items. Returns # of issues found.
+
+        For checkers created with GetFor(), results are cached on disk and
+        only items that changed since the last check are checked again.
+     */
     int Check(Catalog& catalog);
 
     /// Check a single item. Returns # of issues found.
@@ -78,7 +91,13 @@ public:
     void AddCheck(std::shared_ptr<QACheck> c) { m_checks.push_back(c); }
 
 protected:
+    // Runs prepared checks on the item; may be called in parallel
+    int DoCheck(CatalogItemPtr item);
+
     std::vector<std::shared_ptr<QACheck>> m_checks;
+
+    // identifies checks' configuration for caching results; empty if uncacheable
+    std::string m_cacheContext;
 };
 
 #endif // Poedit_qa_checks_h
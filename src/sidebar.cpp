@@ -33,6 +33,7 @@
 #include "configuration.h"
 #include "errors.h"
 #include "hidpi.h"
+#include "text_diff.h"
 #include "utility.h"
 #include "unicode_helpers.h"
 
@@ -160,7 +161,27 @@ public:
 
     void Update(const CatalogItemPtr& item) override
     {
+#if wxCHECK_VERSION(3,1,1)
+        // Show the old text with changes to the current one highlighted:
+        auto diff = DiffTexts(item->GetOldMsgid(), item->GetString());
+
+        wxString text;
+        std::vector<AutoWrappingText::Highlight> highlights;
+        for (auto& chunk: diff->chunks)
+        {
+            if (chunk.op != TextDiff::Op::Equal)
+            {
+                auto style = (chunk.op == TextDiff::Op::Insert) ? AutoWrappingText::Highlight::Style::Inserted
+                                                                : AutoWrappingText::Highlight::Style::Deleted;
+                highlights.push_back({text.length(), chunk.text.length(), style});
+            }
+            text += chunk.text;
+        }
+
+        m_text->SetAndWrapLabel(text, highlights);
+#else
         m_text->SetAndWrapLabel(item->GetOldMsgid());
+#endif
     }
 
 private:
@@ -44,6 +44,8 @@
 
 #include "edapp.h"
 
+#include <algorithm>
+
 
 #ifdef __WXGTK__
 // helper functions that finds GtkTextView of wxTextCtrl:
@@ -176,6 +178,130 @@ bool InitTextCtrlSpellchecker(wxTextCtrl *text, bool enable, const Language& /*l
 #endif // __WXMSW__
 
 
+SpellcheckingService& SpellcheckingService::Get()
+{
+    static SpellcheckingService instance;
+    return instance;
+}
+
+
+bool SpellcheckingService::Attach(wxTextCtrl *text, bool enable, const Language& lang)
+{
+    auto inserted = m_controls.emplace(text, ControlState());
+    if (inserted.second)
+    {
+        text->Bind(wxEVT_DESTROY, [=](wxWindowDestroyEvent& e)
+        {
+            if (e.GetWindow() == text)
+            {
+                m_controls.erase(text);
+                m_deferred.erase(std::remove(m_deferred.begin(), m_deferred.end(), text), m_deferred.end());
+            }
+            e.Skip();
+        });
+    }
+
+    auto& state = inserted.first->second;
+    auto known = m_availableLanguages.find(lang.Code());
+
+    if (state.enabled == enable && state.lang == lang)
+    {
+        // already set up (or scheduled to be) this way, unless the dictionary
+        // should be looked up again (see ForgetMissingDictionaries()):
+        if (!enable)
+            return true;
+        if (state.applied || known != m_availableLanguages.end())
+            return known == m_availableLanguages.end() || known->second;
+    }
+
+    state.enabled = enable;
+    state.lang = lang;
+    state.applied = false;
+
+    // disabling is cheap, no dictionary is involved:
+    if (!enable)
+        return Apply(text, state);
+
+    if (known != m_availableLanguages.end())
+    {
+        // don't repeat (slow) lookup of a dictionary that isn't there:
+        if (!known->second)
+            return false;
+
+        // the dictionary is known to work, so hidden controls (e.g. unused
+        // plural pages) can wait:
+        if (!text->IsShownOnScreen())
+        {
+            m_deferred.push_back(text);
+            if (!m_deferredScheduled)
+            {
+                m_deferredScheduled = true;
+                wxTheApp->CallAfter([=]{ ProcessDeferred(); });
+            }
+            return true;
+        }
+    }
+
+    const bool ok = Apply(text, state);
+    m_availableLanguages[lang.Code()] = ok;
+    return ok;
+}
+
+
+void SpellcheckingService::ForgetMissingDictionaries()
+{
+    for (auto i = m_availableLanguages.begin(); i != m_availableLanguages.end(); )
+    {
+        if (i->second)
+        {
+            ++i;
+            continue;
+        }
+
+        // let controls that failed to use this dictionary try again:
+        for (auto& c: m_controls)
+        {
+            if (c.second.enabled && c.second.lang.Code() == i->first)
+                c.second.applied = false;
+        }
+        i = m_availableLanguages.erase(i);
+    }
+}
+
+
+bool SpellcheckingService::Apply(wxTextCtrl *text, ControlState& state)
+{
+    state.applied = true;
+    return InitTextCtrlSpellchecker(text, state.enabled, state.lang);
+}
+
+
+void SpellcheckingService::ProcessDeferred()
+{
+    m_deferredScheduled = false;
+
+    // set up one control at a time to keep the UI responsive:
+    while (!m_deferred.empty())
+    {
+        auto text = m_deferred.front();
+        m_deferred.erase(m_deferred.begin());
+
+        auto i = m_controls.find(text);
+        if (i == m_controls.end() || i->second.applied)
+            continue;
+
+        Apply(text, i->second);
+        break;
+    }
+
+    if (!m_deferred.empty())
+    {
+        m_deferredScheduled = true;
+        wxTheApp->CallAfter([=]{ ProcessDeferred(); });
+    }
+}
+
+
 #ifndef __WXMSW__
 void ShowSpellcheckerHelp()
 {
@@ -36,6 +36,10 @@
 
 #include "language.h"
 
+#include <map>
+#include <string>
+#include <vector>
+
 inline bool IsSpellcheckingAvailable()
 {
 #ifdef __WXMSW__
@@ -58,6 +62,53 @@ void PrepareTextCtrlForSpellchecker(wxTextCtrl *text);
 // Init given text control to do (or not) spellchecking for given language
 bool InitTextCtrlSpellchecker(wxTextCtrl *text, bool enable, const Language& lang);
 
+/**
+    Shared spellchecking setup for all translation text controls.
+
+    Remembers how each control is configured, so that repeated calls (e.g.
+    after recreating plural form pages) are no-ops, and which languages'
+    dictionaries are available, so that a missing dictionary is looked up
+    only once per setup of the editor. Only the first control to use a language loads it right away;
+    controls that aren't currently shown are set up later, in idle time.
+ */
+class SpellcheckingService
+{
+public:
+    static SpellcheckingService& Get();
+
+    /**
+        Enables or disables spellchecking in @a text for language @a lang.
+
+        @return false if the dictionary for @a lang isn't available.
+     */
+    bool Attach(wxTextCtrl *text, bool enable, const Language& lang);
+
+    /**
+        Forgets which dictionaries were found missing, so that they are
+        looked up again by the next Attach() call. Call when the user may
+        have installed dictionaries, e.g. when (re)configuring spellchecking.
+     */
+    void ForgetMissingDictionaries();
+
+private:
+    SpellcheckingService() : m_deferredScheduled(false) {}
+
+    struct ControlState
+    {
+        bool enabled = false;
+        Language lang;
+        bool applied = false;
+    };
+
+    bool Apply(wxTextCtrl *text, ControlState& state);
+    void ProcessDeferred();
+
+    std::map<wxTextCtrl*, ControlState> m_controls;
+    std::map<std::string, bool> m_availableLanguages;
+    std::vector<wxTextCtrl*> m_deferred;
+    bool m_deferredScheduled;
+};
+
 #ifndef __WXMSW__
 // Show help about how to add more dictionaries for spellchecking.
 void ShowSpellcheckerHelp();
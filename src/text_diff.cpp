@@ -0,0 +1,346 @@
+/*
+ *  This file is part of Poedit (https://poedit.net)
+ *
+ *  Copyright (C) 2020 Vaclav Slavik
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "text_diff.h"
+
+#include <algorithm>
+#include <cwctype>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace
+{
+
+// Limit on the edit distance (in tokens) the exact diff is computed for.
+// The cost of Myers' algorithm is O((N+M)*D) time and O(D^2) memory, so this
+// bounds the worst case even for very long texts; beyond it, the result
+// wouldn't be very readable anyway.
+const int MAX_EDIT_DISTANCE = 500;
+
+// How many diffs to remember
+const size_t CACHE_SIZE = 128;
+
+
+struct Token
+{
+    size_t start, length;
+    int id;  // identical tokens have the same ID
+};
+
+inline bool IsIdeographic(wchar_t c)
+{
+    return (c >= 0x3040 && c <= 0x30FF) ||  // Hiragana, Katakana
+           (c >= 0x3400 && c <= 0x4DBF) ||  // CJK Extension A
+           (c >= 0x4E00 && c <= 0x9FFF) ||  // CJK Unified Ideographs
+           (c >= 0xF900 && c <= 0xFAFF);    // CJK Compatibility Ideographs
+}
+
+enum class CharClass { Word, Space, Other };
+
+inline CharClass Classify(wchar_t c)
+{
+    if (std::iswspace(c))
+        return CharClass::Space;
+    if ((std::iswalnum(c) || c == '_') && !IsIdeographic(c))
+        return CharClass::Word;
+    return CharClass::Other;
+}
+
+// Split text into words, whitespace runs and other characters. Tokens
+// are interned in @a ids so that they can be compared as integers.
+std::vector<Token> Tokenize(const std::wstring& text, std::unordered_map<std::wstring, int>& ids)
+{
+    std::vector<Token> tokens;
+    const size_t len = text.length();
+    size_t pos = 0;
+    while (pos < len)
+    {
+        auto cls = Classify(text[pos]);
+        size_t end = pos + 1;
+        if (cls != CharClass::Other)
+        {
+            while (end < len && Classify(text[end]) == cls)
+                end++;
+        }
+
+        auto inserted = ids.emplace(text.substr(pos, end - pos), (int)ids.size());
+        tokens.push_back({pos, end - pos, inserted.first->second});
+        pos = end;
+    }
+    return tokens;
+}
+
+
+enum class EditOp { Equal, Insert, Delete };
+
+/**
+    Myers' O(ND) diff of a[0..n) and b[0..m).
+
+    Appends edit script to @a script (in reverse order) and returns true,
+    or returns false if the edit distance exceeds MAX_EDIT_DISTANCE.
+ */
+bool MyersDiff(const int *a, int n, const int *b, int m, std::vector<EditOp>& script)
+{
+    const int maxD = std::min(n + m, MAX_EDIT_DISTANCE);
+    const int offset = maxD + 1;
+    std::vector<int> v(2 * offset + 1, 0);
+
+    // trace[d] holds v[-d..d] as it was at the start of step d
+    std::vector<std::vector<int>> trace;
+
+    int finalD = -1;
+    for (int d = 0; d <= maxD && finalD == -1; d++)
+    {
+        trace.emplace_back(v.begin() + offset - d, v.begin() + offset + d + 1);
+
+        for (int k = -d; k <= d; k += 2)
+        {
+            int x;
+            if (k == -d || (k != d && v[offset + k - 1] < v[offset + k + 1]))
+                x = v[offset + k + 1];      // step down, i.e. insertion
+            else
+                x = v[offset + k - 1] + 1;  // step right, i.e. deletion
+            int y = x - k;
+
+            while (x < n && y < m && a[x] == b[y])
+            {
+                x++;
+                y++;
+            }
+
+            v[offset + k] = x;
+            if (x >= n && y >= m)
+            {
+                finalD = d;
+                break;
+            }
+        }
+    }
+
+    if (finalD == -1)
+        return false;
+
+    // Backtrack from (n,m) to (0,0):
+    int x = n, y = m;
+    for (int d = finalD; d > 0; d--)
+    {
+        const auto& prev = trace[d];
+        auto prevV = [&](int k){ return prev[k + d]; };
+
+        const int k = x - y;
+        int prevK;
+        if (k == -d || (k != d && prevV(k - 1) < prevV(k + 1)))
+            prevK = k + 1;
+        else
+            prevK = k - 1;
+
+        const int prevX = prevV(prevK);
+        const int prevY = prevX - prevK;
+
+        while (x > prevX && y > prevY)
+        {
+            script.push_back(EditOp::Equal);
+            x--;
+            y--;
+        }
+
+        script.push_back(prevK == k + 1 ? EditOp::Insert : EditOp::Delete);
+        x = prevX;
+        y = prevY;
+    }
+
+    while (x > 0 && y > 0)
+    {
+        script.push_back(EditOp::Equal);
+        x--;
+        y--;
+    }
+
+    return true;
+}
+
+
+class DiffBuilder
+{
+public:
+    DiffBuilder(TextDiff& diff) : m_diff(diff) {}
+
+    ~DiffBuilder()
+    {
+        FlushChange();
+    }
+
+    void Equal(const std::wstring& s)
+    {
+        FlushChange();
+        Append(TextDiff::Op::Equal, s);
+    }
+
+    void Delete(const std::wstring& s) { m_deleted += s; }
+    void Insert(const std::wstring& s) { m_inserted += s; }
+
+private:
+    void FlushChange()
+    {
+        if (!m_deleted.empty())
+            Append(TextDiff::Op::Delete, m_deleted);
+        if (!m_inserted.empty())
+            Append(TextDiff::Op::Insert, m_inserted);
+        m_deleted.clear();
+        m_inserted.clear();
+    }
+
+    void Append(TextDiff::Op op, const std::wstring& s)
+    {
+        if (s.empty())
+            return;
+        if (!m_diff.chunks.empty() && m_diff.chunks.back().op == op)
+            m_diff.chunks.back().text += s;
+        else
+            m_diff.chunks.push_back({op, s});
+    }
+
+    TextDiff& m_diff;
+    std::wstring m_deleted, m_inserted;
+};
+
+
+std::shared_ptr<TextDiff> ComputeDiff(const std::wstring& oldText, const std::wstring& newText)
+{
+    auto diff = std::make_shared<TextDiff>();
+
+    std::unordered_map<std::wstring, int> ids;
+    auto a = Tokenize(oldText, ids);
+    auto b = Tokenize(newText, ids);
+
+    auto tokenText = [](const std::wstring& text, const Token& t) { return text.substr(t.start, t.length); };
+
+    // Common prefix and suffix are cheap to find and often most of the text:
+    size_t prefix = 0;
+    while (prefix < a.size() && prefix < b.size() && a[prefix].id == b[prefix].id)
+        prefix++;
+    size_t suffix = 0;
+    while (suffix < a.size() - prefix && suffix < b.size() - prefix &&
+           a[a.size() - 1 - suffix].id == b[b.size() - 1 - suffix].id)
+    {
+        suffix++;
+    }
+
+    std::vector<int> aIds, bIds;
+    for (size_t i = prefix; i < a.size() - suffix; i++)
+        aIds.push_back(a[i].id);
+    for (size_t i = prefix; i < b.size() - suffix; i++)
+        bIds.push_back(b[i].id);
+
+    DiffBuilder builder(*diff);
+
+    if (prefix > 0)
+        builder.Equal(oldText.substr(0, a[prefix - 1].start + a[prefix - 1].length));
+
+    std::vector<EditOp> script;
+    if (MyersDiff(aIds.data(), (int)aIds.size(), bIds.data(), (int)bIds.size(), script))
+    {
+        size_t ai = prefix, bi = prefix;
+        for (auto i = script.rbegin(); i != script.rend(); ++i)
+        {
+            switch (*i)
+            {
+                case EditOp::Equal:
+                    builder.Equal(tokenText(oldText, a[ai]));
+                    ai++;
+                    bi++;
+                    break;
+                case EditOp::Delete:
+                    builder.Delete(tokenText(oldText, a[ai]));
+                    ai++;
+                    break;
+                case EditOp::Insert:
+                    builder.Insert(tokenText(newText, b[bi]));
+                    bi++;
+                    break;
+            }
+        }
+    }
+    else
+    {
+        diff->approximate = true;
+        for (size_t i = prefix; i < a.size() - suffix; i++)
+            builder.Delete(tokenText(oldText, a[i]));
+        for (size_t i = prefix; i < b.size() - suffix; i++)
+            builder.Insert(tokenText(newText, b[i]));
+    }
+
+    if (suffix > 0)
+        builder.Equal(oldText.substr(a[a.size() - suffix].start));
+
+    return diff;
+}
+
+
+// Memoized results, most recently used first
+class DiffCache
+{
+public:
+    std::shared_ptr<const TextDiff> Get(const std::wstring& oldText, const std::wstring& newText)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        for (auto i = m_entries.begin(); i != m_entries.end(); ++i)
+        {
+            if (i->newText == newText && i->oldText == oldText)
+            {
+                m_entries.splice(m_entries.begin(), m_entries, i);
+                return i->diff;
+            }
+        }
+
+        auto diff = ComputeDiff(oldText, newText);
+        m_entries.push_front({oldText, newText, diff});
+        if (m_entries.size() > CACHE_SIZE)
+            m_entries.pop_back();
+        return diff;
+    }
+
+private:
+    struct Entry
+    {
+        std::wstring oldText, newText;
+        std::shared_ptr<const TextDiff> diff;
+    };
+
+    std::mutex m_mutex;
+    std::list<Entry> m_entries;
+};
+
+} // anonymous namespace
+
+
+std::shared_ptr<const TextDiff> DiffTexts(const wxString& oldText, const wxString& newText)
+{
+    static DiffCache s_cache;
+    return s_cache.Get(oldText.ToStdWstring(), newText.ToStdWstring());
+}
@@ -0,0 +1,74 @@
+/*
+ *  This file is part of Poedit (https://poedit.net)
+ *
+ *  Copyright (C) 2020 Vaclav Slavik
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef Poedit_text_diff_h
+#define Poedit_text_diff_h
+
+#include <wx/string.h>
+
+#include <memory>
+#include <vector>
+
+
+/// Word-level difference between two texts, see DiffTexts().
+struct TextDiff
+{
+    enum class Op
+    {
+        Equal,
+        Insert,
+        Delete
+    };
+
+    struct Chunk
+    {
+        Op op;
+        wxString text;
+    };
+
+    /// Chunks of both texts in order; a changed part is represented as
+    /// Delete chunk immediately followed by Insert chunk.
+    std::vector<Chunk> chunks;
+
+    /// True if the texts were too different to compute the exact diff and
+    /// the changed part is described coarsely, as one deletion and insertion.
+    bool approximate = false;
+};
+
+
+/**
+    Computes word-level difference between @a oldText and @a newText.
+
+    The texts are split into words, whitespace runs and individual punctuation
+    (or ideographic) characters and compared using Myers' O(ND) algorithm.
+    The amount of work is capped: if there are too many differences, the
+    result is approximate (see TextDiff::approximate).
+
+    Results are memoized, so calling this repeatedly for the same pair of
+    texts (e.g. when navigating back and forth in the list) is cheap.
+ */
+std::shared_ptr<const TextDiff> DiffTexts(const wxString& oldText, const wxString& newText);
+
+#endif // Poedit_text_diff_h
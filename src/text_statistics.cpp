@@ -0,0 +1,170 @@
+/*
+ *  This file is part of Poedit (https://poedit.net)
+ *
+ *  Copyright (C) 2020 Vaclav Slavik
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "text_statistics.h"
+
+#include "concurrency.h"
+#include "str_helpers.h"
+
+#include <unicode/brkiter.h>
+#include <unicode/uchar.h>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+
+namespace
+{
+
+// Minimal number of items to count on a single background thread
+const size_t PARALLEL_CHUNK_SIZE = 2000;
+
+
+// Returns word iterator for the language. ICU iterators are expensive to
+// create, but aren't thread-safe, so they are cached per-thread.
+icu::BreakIterator *GetWordIterator(const Language& lang)
+{
+    thread_local std::map<std::string, std::unique_ptr<icu::BreakIterator>> s_iterators;
+
+    auto name = lang.IcuLocaleName();
+    auto& iter = s_iterators[name];
+    if (!iter)
+    {
+        UErrorCode err = U_ZERO_ERROR;
+        iter.reset(icu::BreakIterator::createWordInstance(lang.IsValid() ? lang.ToIcu() : icu::Locale::getEnglish(), err));
+        if (!iter || U_FAILURE(err))
+        {
+            err = U_ZERO_ERROR;
+            iter.reset(icu::BreakIterator::createWordInstance(icu::Locale::getEnglish(), err));
+        }
+    }
+    return iter.get();
+}
+
+
+void CountItem(CatalogItem& item, const Language& srclang, const Language& lang)
+{
+    CatalogItem::WordCounts c;
+
+    CountWordsAndChars(item.GetString(), srclang, c.sourceWords, c.sourceChars);
+    if (item.HasPlural())
+    {
+        int words, chars;
+        CountWordsAndChars(item.GetPluralString(), srclang, words, chars);
+        c.sourceWords += words;
+        c.sourceChars += chars;
+    }
+
+    c.translationWords = c.translationChars = 0;
+    for (auto& t: item.GetTranslations())
+    {
+        int words, chars;
+        CountWordsAndChars(t, lang, words, chars);
+        c.translationWords += words;
+        c.translationChars += chars;
+    }
+
+    item.SetCachedWordCounts(c);
+}
+
+} // anonymous namespace
+
+
+void CountWordsAndChars(const wxString& text, const Language& lang, int& words, int& chars)
+{
+    words = chars = 0;
+    if (text.empty())
+        return;
+
+    auto utext = str::to_icu(text);
+
+    for (int32_t i = 0; i < utext.length(); i = utext.moveIndex32(i, 1))
+    {
+        if (!u_isUWhiteSpace(utext.char32At(i)))
+            chars++;
+    }
+
+    auto iter = GetWordIterator(lang);
+    if (!iter)
+        return;
+
+    iter->setText(utext);
+    for (int32_t pos = iter->next(); pos != icu::BreakIterator::DONE; pos = iter->next())
+    {
+        // only count segments that are words, numbers etc.,
+        // not whitespace or punctuation:
+        if (iter->getRuleStatus() != UBRK_WORD_NONE)
+            words++;
+    }
+}
+
+
+WordStatistics GetWordStatistics(const CatalogPtr& catalog)
+{
+    auto srclang = catalog->GetSourceLanguage();
+    auto lang = catalog->GetLanguage();
+
+    std::vector<CatalogItemPtr> stale;
+    for (auto& item: catalog->items())
+    {
+        if (!item->HasCachedWordCounts())
+            stale.push_back(item);
+    }
+
+    if (stale.size() < 2 * PARALLEL_CHUNK_SIZE)
+    {
+        for (auto& item: stale)
+            CountItem(*item, srclang, lang);
+    }
+    else
+    {
+        std::vector<dispatch::future<void>> chunks;
+        for (size_t begin = 0; begin < stale.size(); begin += PARALLEL_CHUNK_SIZE)
+        {
+            const size_t end = std::min(stale.size(), begin + PARALLEL_CHUNK_SIZE);
+            chunks.push_back(dispatch::async([&stale, begin, end, srclang, lang]{
+                for (size_t i = begin; i < end; i++)
+                    CountItem(*stale[i], srclang, lang);
+            }));
+        }
+        for (auto& c: chunks)
+            c.get();
+    }
+
+    WordStatistics stats;
+    for (auto& item: catalog->items())
+    {
+        auto& c = item->GetCachedWordCounts();
+        stats.sourceWords += c.sourceWords;
+        stats.sourceChars += c.sourceChars;
+        stats.translationWords += c.translationWords;
+        stats.translationChars += c.translationChars;
+        if (item->IsFuzzy() || !item->IsTranslated())
+            stats.remainingWords += c.sourceWords;
+    }
+
+    return stats;
+}
@@ -0,0 +1,68 @@
+/*
+ *  This file is part of Poedit (https://poedit.net)
+ *
+ *  Copyright (C) 2020 Vaclav Slavik
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef Poedit_text_statistics_h
+#define Poedit_text_statistics_h
+
+#include "catalog.h"
+
+
+/// Word and character counts of a catalog's content.
+struct WordStatistics
+{
+    WordStatistics()
+        : sourceWords(0), sourceChars(0),
+          remainingWords(0),
+          translationWords(0), translationChars(0) {}
+
+    /// Words and characters in all source texts
+    int sourceWords, sourceChars;
+    /// Source words in entries that aren't finished yet (untranslated or
+    /// fuzzy), i.e. the amount of work left
+    int remainingWords;
+    /// Words and characters in all translations
+    int translationWords, translationChars;
+};
+
+
+/**
+    Counts words and characters in the text.
+
+    Words are determined using ICU's word segmentation rules for the given
+    language, i.e. work for languages that don't separate words with spaces
+    too. Only non-whitespace characters are counted.
+ */
+void CountWordsAndChars(const wxString& text, const Language& lang, int& words, int& chars);
+
+/**
+    Computes word statistics of the catalog.
+
+    Per-item counts are cached in the items and only items that were
+    modified since the last call are re-counted. If there are many of them
+    (typically when called for the first time), they are counted in parallel.
+ */
+WordStatistics GetWordStatistics(const CatalogPtr& catalog);
+
+#endif // Poedit_text_statistics_h
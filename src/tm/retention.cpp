@@ -0,0 +1,184 @@
+/*
+ *  This file is part of Poedit (https://poedit.net)
+ *
+ *  Copyright (C) 2020 Vaclav Slavik
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "retention.h"
+
+#include "catalog_po.h"
+#include "catalog_xliff.h"
+#include "compression.h"
+#include "configuration.h"
+#include "manager.h"
+#include "str_helpers.h"
+
+#include <wx/filename.h>
+#include <wx/intl.h>
+#include <wx/log.h>
+#include <wx/numformatter.h>
+
+#include <time.h>
+
+namespace
+{
+
+// How often is the policy applied automatically
+const long AUTO_PRUNE_INTERVAL = 7 * 24 * 60 * 60;
+
+// Collects source texts of all catalogs in given directories
+std::shared_ptr<const std::unordered_set<std::wstring>> CollectSourceTexts(const wxArrayString& dirs)
+{
+    wxArrayString files;
+    for (auto& dir: dirs)
+        ManagerFrame::FindCatalogsInDir(dir, files);
+
+    auto sources = std::make_shared<std::unordered_set<std::wstring>>();
+
+    // suppress error messages, we don't mind if some catalog is corrupted
+    wxLogNull nullLog;
+
+    for (auto& file: files)
+    {
+        wxString ext;
+        wxFileName::SplitPath(StripGzipExtension(file), nullptr, nullptr, nullptr, &ext);
+        if (XLIFFCatalog::CanLoadFile(ext.Lower()))
+        {
+            try
+            {
+                XLIFFStreamReader reader(file);
+                reader.ForEachUnit([&](const XLIFFStreamReader::Unit& u)
+                {
+                    sources->insert(str::to_wstring(u.source));
+                });
+            }
+            catch (...)
+            {
+                // corrupted file, use whatever was read before the error
+            }
+        }
+        else
+        {
+            POStreamReader reader(file);
+            reader.ForEachEntry([&](const POStreamReader::Entry& e)
+            {
+                sources->insert(str::to_wstring(e.source));
+                if (e.hasPlural)
+                    sources->insert(str::to_wstring(e.sourcePlural));
+                return true;
+            });
+        }
+    }
+
+    return sources;
+}
+
+} // anonymous namespace
+
+
+namespace TMRetention
+{
+
+bool IsEnabled()
+{
+    return Config::TMMaxAgeDays() > 0 ||
+           Config::TMMaxEntriesPerLanguage() > 0 ||
+           Config::TMRemoveUnused();
+}
+
+
+dispatch::future<TranslationMemory::PruneReport> PruneAsync()
+{
+    TranslationMemory::RetentionPolicy policy;
+    policy.maxAgeDays = Config::TMMaxAgeDays();
+    policy.maxEntriesPerLanguage = Config::TMMaxEntriesPerLanguage();
+
+    // projects are stored in wxConfig, which can only be used on the main thread:
+    wxArrayString projectsDirs;
+    if (Config::TMRemoveUnused())
+        projectsDirs = ManagerFrame::GetAllProjectsDirs();
+
+    return dispatch::async([=]
+    {
+        auto p = policy;
+        if (!projectsDirs.empty())
+        {
+            // without any known sources, this rule would remove everything:
+            auto sources = CollectSourceTexts(projectsDirs);
+            if (!sources->empty())
+                p.knownSources = sources;
+        }
+
+        auto report = TranslationMemory::Get().Prune(p);
+        Config::TMLastPruned((long)time(NULL));
+        return report;
+    });
+}
+
+
+void PruneIfDue()
+{
+    if (!Config::UseTM() || !IsEnabled())
+        return;
+    if (time(NULL) - Config::TMLastPruned() < AUTO_PRUNE_INTERVAL)
+        return;
+
+    PruneAsync()
+    .then([](TranslationMemory::PruneReport report)
+    {
+        wxLogTrace("poedit.tm", "automatic pruning: %s", DescribeReport(report));
+    })
+    .catch_all([](dispatch::exception_ptr)
+    {
+        // errors will be reported by real use of the TM
+    });
+}
+
+
+wxString DescribeReport(const TranslationMemory::PruneReport& r)
+{
+    const long removed = r.GetRemovedCount();
+    if (removed == 0)
+        return _("No translations had to be removed from the translation memory.");
+
+    wxString s = wxString::Format(wxPLURAL("Removed %s translation from the translation memory.",
+                                           "Removed %s translations from the translation memory.",
+                                           (int)removed),
+                                  wxNumberFormatter::ToString(removed));
+    s += "\n\n";
+    s += wxString::Format(_("Stored translations: %s (was %s)"),
+                          wxNumberFormatter::ToString(r.numDocsAfter),
+                          wxNumberFormatter::ToString(r.numDocsBefore));
+    s += "\n";
+    s += wxString::Format(_("Database size on disk: %s (was %s)"),
+                          wxFileName::GetHumanReadableSize(r.fileSizeAfter, "--", 1, wxSIZE_CONV_SI),
+                          wxFileName::GetHumanReadableSize(r.fileSizeBefore, "--", 1, wxSIZE_CONV_SI));
+    if (r.searchTimeBefore > 0)
+    {
+        s += "\n";
+        s += wxString::Format(_("Average search time: %.1f ms (was %.1f ms)"),
+                              r.searchTimeAfter, r.searchTimeBefore);
+    }
+    return s;
+}
+
+} // namespace TMRetention
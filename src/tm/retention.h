@@ -0,0 +1,67 @@
+/*
+ *  This file is part of Poedit (https://poedit.net)
+ *
+ *  Copyright (C) 2020 Vaclav Slavik
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef Poedit_retention_h
+#define Poedit_retention_h
+
+#include "concurrency.h"
+#include "transmem.h"
+
+#include <wx/string.h>
+
+
+/**
+    Applying of the TM retention policy configured in preferences.
+
+    Entries older than the configured age are removed, languages are capped
+    to the configured number of newest entries and, optionally, entries whose
+    source text isn't used in any Catalogs Manager project are removed.
+ */
+namespace TMRetention
+{
+
+/// Is any retention rule enabled?
+bool IsEnabled();
+
+/**
+    Prunes the TM according to the configured policy, in the background.
+
+    If removal of unused entries is enabled, source texts of all catalogs in
+    Catalogs Manager projects are collected first, in the background too.
+    If there are no such catalogs, this rule is ignored.
+
+    Must be called on the main thread.
+ */
+dispatch::future<TranslationMemory::PruneReport> PruneAsync();
+
+/// Calls PruneAsync() if a policy is configured and it wasn't done recently.
+void PruneIfDue();
+
+/// Returns human-readable summary of the results.
+wxString DescribeReport(const TranslationMemory::PruneReport& report);
+
+} // namespace TMRetention
+
+#endif // Poedit_retention_h
@@ -75,7 +75,7 @@ std::wstring extract_seg(xml_node node)
 } // anonymous namespace
 
 
-void TMX::ImportFromFile(std::istream& file, TranslationMemory& tm)
+TranslationMemory::InsertStats TMX::ImportFromFile(std::istream& file, TranslationMemory& tm)
 {
     xml_document doc;
     auto result = doc.load(file);
@@ -102,7 +102,7 @@ void TMX::ImportFromFile(std::istream& file, TranslationMemory& tm)
     if (!body)
         throw Exception(_("The TMX file is malformed."));
 
-    tm.ImportData([=,&counter,&body](auto& writer)
+    auto stats = tm.ImportData([=,&counter,&body](auto& writer)
     {
         for (auto tu: body.children("tu"))
         {
@@ -157,6 +157,8 @@ void TMX::ImportFromFile(std::istream& file, TranslationMemory& tm)
 
     if (counter == 0)
         throw Exception(_("No translations were found in the TMX file."));
+
+    return stats;
 }
 
 
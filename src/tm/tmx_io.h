@@ -35,7 +35,8 @@
 namespace TMX
 {
 
-void ImportFromFile(std::istream& file, TranslationMemory& tm);
+/// Returns counts of added, updated and skipped (already stored) entries.
+TranslationMemory::InsertStats ImportFromFile(std::istream& file, TranslationMemory& tm);
 
 void ExportToFile(TranslationMemory& tm, std::ostream& file);
 
@@ -26,6 +26,8 @@
 #include "transmem.h"
 
 #include "catalog.h"
+#include "concurrency.h"
+#include "configuration.h"
 #include "errors.h"
 #include "str_helpers.h"
 #include "utility.h"
@@ -35,9 +37,21 @@
 #include <wx/dir.h>
 #include <wx/filename.h>
 #include <wx/translation.h>
+#include <wx/log.h>
 
 #include <time.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cwchar>
+#include <condition_variable>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include <unicode/brkiter.h>
 
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_io.hpp>
@@ -56,10 +70,15 @@
 #include <Document.h>
 #include <Field.h>
 #include <DateField.h>
+#include <MapFieldSelector.h>
 #include <PrefixQuery.h>
 #include <StringUtils.h>
+#include <TermDocs.h>
+#include <TermEnum.h>
 #include <TermQuery.h>
 #include <BooleanQuery.h>
+#include <CachingWrapperFilter.h>
+#include <QueryWrapperFilter.h>
 #include <PhraseQuery.h>
 #include <Term.h>
 #include <ScoreDoc.h>
@@ -95,6 +114,13 @@ namespace
     }
 
 
+// Minimal time between reopening the searcher's reader because of additions
+const std::chrono::milliseconds REOPEN_MIN_INTERVAL(1000);
+
+// ...unless this many changes accumulated in the meantime
+const int REOPEN_MAX_CHANGES = 100;
+
+
 // Manages IndexReader and Searcher instances in multi-threaded environment.
 // Curiously, Lucene uses shared_ptr-based refcounting *and* explicit one as
 // well, with a crucial part not well protected.
@@ -104,13 +130,26 @@ namespace
 // class, see
 // http://blog.mikemccandless.com/2011/09/lucenes-searchermanager-simplifies.html
 // http://blog.mikemccandless.com/2011/11/near-real-time-readers-with-lucenes.html
+//
+// Readers are obtained from the writer ("near-real-time" readers), so they
+// include uncommitted changes too. Lucene's isCurrent() only detects commits,
+// though, so the writer must call MarkChanged() after modifying the index.
+//
+// Reopening a NRT reader flushes the writer's buffered documents into a new
+// segment. Doing it on every search during bulk inserts would produce lots of
+// tiny segments, so searches pick up ordinary additions lazily, at most once
+// per REOPEN_MIN_INTERVAL or once REOPEN_MAX_CHANGES accumulated. Changes
+// marked as immediate (deletions, entries confirmed while translating, which
+// are written in batches already) and Reader() users (statistics, export,
+// maintenance) always see the current state.
 class SearcherManager
 {
 public:
-    SearcherManager(IndexWriterPtr writer)
+    SearcherManager(IndexWriterPtr writer) : m_changed(false), m_urgent(false), m_pendingChanges(0)
     {
         m_reader = writer->getReader();
         m_searcher = newLucene<IndexSearcher>(m_reader);
+        m_lastReopen = std::chrono::steady_clock::now();
     }
 
     ~SearcherManager()
@@ -146,7 +185,7 @@ public:
     SafeRef<IndexReader> Reader()
     {
         std::lock_guard<std::mutex> guard(m_mutex);
-        ReloadReaderIfNeeded();
+        ReloadReaderIfNeeded(/*allowDelay=*/false);
         m_reader->incRef();
         return SafeRef<IndexReader>(*this, m_reader);
     }
@@ -154,18 +193,48 @@ public:
     SafeRef<IndexSearcher> Searcher()
     {
         std::lock_guard<std::mutex> guard(m_mutex);
-        ReloadReaderIfNeeded();
+        ReloadReaderIfNeeded(/*allowDelay=*/true);
         m_searcher->getIndexReader()->incRef();
         return SafeRef<IndexSearcher>(*this, m_searcher);
     }
 
+    // Notifies the manager about uncommitted changes done by the writer.
+    // Pass immediately=true for changes that searches must not miss even
+    // briefly (e.g. deletions).
+    void MarkChanged(bool immediately = false)
+    {
+        m_pendingChanges++;
+        if (immediately)
+            m_urgent = true;
+        m_changed = true;
+    }
+
 private:
-    void ReloadReaderIfNeeded()
+    void ReloadReaderIfNeeded(bool allowDelay)
     {
         // contract: m_mutex is locked when this function is called
-        if (m_reader->isCurrent())
+        if (!m_changed && m_reader->isCurrent())
             return; // nothing to do
 
+        auto now = std::chrono::steady_clock::now();
+        if (allowDelay &&
+            !m_urgent &&
+            m_pendingChanges < REOPEN_MAX_CHANGES &&
+            now - m_lastReopen < REOPEN_MIN_INTERVAL)
+        {
+            return; // keep using the current, slightly stale reader for now
+        }
+
+        // reset before reopening, so that changes made concurrently are
+        // either included in the new reader or flagged again:
+        m_changed = false;
+        m_urgent = false;
+        m_pendingChanges = 0;
+        m_lastReopen = now;
+
+        // NB: reopen() of a reader obtained from IndexWriter gets a fresh
+        //     reader from the writer, including its uncommitted changes
+
         auto newReader = m_reader->reopen();
         auto newSearcher = newLucene<IndexSearcher>(newReader);
 
@@ -189,6 +258,9 @@ private:
     IndexReaderPtr   m_reader;
     IndexSearcherPtr m_searcher;
     std::mutex       m_mutex;
+    std::atomic_bool m_changed, m_urgent;
+    std::atomic_int  m_pendingChanges;
+    std::chrono::steady_clock::time_point m_lastReopen;
 };
 
 
@@ -198,6 +270,9 @@ private:
 // TranslationMemoryImpl
 // ----------------------------------------------------------------
 
+class TranslationMemoryWriterImpl;
+class TranslationMemoryInsertQueue;
+
 class TranslationMemoryImpl
 {
 public:
@@ -207,35 +282,134 @@ public:
     typedef MMapDirectory DirectoryType;
 #endif
 
-    TranslationMemoryImpl() { Init(); }
+    TranslationMemoryImpl() : m_shuttingDown(false), m_runningTasks(0), m_closed(false) { Init(); }
+
+    ~TranslationMemoryImpl() { Shutdown(); }
 
-    ~TranslationMemoryImpl()
+    /**
+        Closes the database. Running operations are waited for (background
+        ones, i.e. warm-up and pruning, are aborted) and queued inserts are
+        written out. Calls made after this fail or do nothing.
+     */
+    void Shutdown()
     {
+        m_shuttingDown = true;
+        {
+            std::unique_lock<std::mutex> lock(m_tasksMutex);
+            m_tasksFinished.wait(lock, [=]{ return m_runningTasks == 0; });
+            if (m_closed)
+                return;
+            m_closed = true;
+        }
+
+        // write out everything still queued before closing the writer
+        m_insertQueue.reset();
         m_mng.reset();
-        m_writer->close();
+        try
+        {
+            m_writer->close();
+        }
+        catch (...) {}
     }
 
     SuggestionsList Search(const Language& srclang, const Language& lang,
                            const std::wstring& source);
 
     void ExportData(TranslationMemory::IOInterface& destination);
-    void ImportData(std::function<void(TranslationMemory::IOInterface&)> source);
+    TranslationMemory::InsertStats ImportData(std::function<void(TranslationMemory::IOInterface&)> source);
+
+    std::shared_ptr<TranslationMemory::Writer> GetWriter();
+
+    void InsertAsync(const Language& srclang, const Language& lang, const CatalogItemPtr& item);
+    void FlushQueuedInserts();
 
-    std::shared_ptr<TranslationMemory::Writer> GetWriter() { return m_writerAPI; }
+    void WarmUp(const Language& srclang, const Language& lang,
+                const std::vector<std::wstring>& samples);
 
     void GetStats(long& numDocs, long& fileSize);
 
+    TranslationMemory::PruneReport Prune(const TranslationMemory::RetentionPolicy& policy);
+
     static std::wstring GetDatabaseDir();
 
 private:
     void Init();
 
+    struct SampleQuery
+    {
+        Language srclang, lang;
+        std::wstring source;
+    };
+    std::vector<SampleQuery> PickSampleQueries();
+    double MeasureSearchTime(const std::vector<SampleQuery>& samples);
+
+    // Returns filter restricting results to given languages. Sentences
+    // derived from longer entries are only included if @a withSegments is
+    // set; they are aligned only heuristically and mustn't show up as
+    // ordinary (possibly 100%) matches.
+    FilterPtr GetLanguageFilter(const Language& srclang, const Language& lang, bool withSegments);
+
+    bool FindExactTranslation(IndexSearcherPtr searcher, FilterPtr langFilter,
+                              const Lucene::String& preferredLang,
+                              const std::wstring& source, std::wstring& translation);
+    bool SearchBySentences(IndexSearcherPtr searcher, FilterPtr langFilter,
+                           const Lucene::String& preferredLang,
+                           const Language& srclang, const Language& lang,
+                           const std::wstring& source, SuggestionsList& results);
+
 private:
     AnalyzerPtr      m_analyzer;
     IndexWriterPtr   m_writer;
     std::shared_ptr<SearcherManager> m_mng;
 
-    std::shared_ptr<TranslationMemory::Writer> m_writerAPI;
+    std::shared_ptr<TranslationMemoryWriterImpl> m_writerAPI;
+    std::unique_ptr<TranslationMemoryInsertQueue> m_insertQueue;
+
+    // Language restrictions of queries, keyed by srclang+lang (and inclusion
+    // of derived sentences); the filters cache their matching documents for
+    // every (segment) reader they see:
+    std::map<std::wstring, FilterPtr> m_langFilters;
+    std::mutex m_langFiltersMutex;
+
+    // Registers a running operation for its lifetime, so that Shutdown()
+    // waits for it; evaluates to false if the TM is already shutting down.
+    // Every public method that uses the index must hold one, because callers
+    // may keep using the object after it was replaced in DeleteAllAndReset().
+    class UsageGuard
+    {
+    public:
+        UsageGuard(TranslationMemoryImpl& tm) : m_tm(tm)
+        {
+            std::lock_guard<std::mutex> lock(m_tm.m_tasksMutex);
+            m_ok = !m_tm.m_shuttingDown;
+            if (m_ok)
+                m_tm.m_runningTasks++;
+        }
+
+        ~UsageGuard()
+        {
+            if (!m_ok)
+                return;
+            std::lock_guard<std::mutex> lock(m_tm.m_tasksMutex);
+            if (--m_tm.m_runningTasks == 0)
+                m_tm.m_tasksFinished.notify_all();
+        }
+
+        explicit operator bool() const { return m_ok; }
+
+    private:
+        TranslationMemoryImpl& m_tm;
+        bool m_ok;
+    };
+
+    // held while pruning, so that only one pruning runs at a time
+    std::mutex m_pruneMutex;
+
+    std::atomic_bool m_shuttingDown;
+    std::mutex m_tasksMutex;
+    std::condition_variable m_tasksFinished;
+    int m_runningTasks;
+    bool m_closed;
 };
 
 
@@ -272,6 +446,15 @@ static const double QUALITY_THRESHOLD = 0.6;
 // Maximum allowed difference in phrase length, in #terms.
 static const int MAX_ALLOWED_LENGTH_DIFFERENCE = 2;
 
+// Scaling applied to non-exact matches found in a different variant of the
+// language (e.g. "pt" for "pt_BR"), so that the exact variant is preferred.
+static const double SECONDARY_LANG_SCALING = 0.95;
+
+// Number of hits fetched for re-scoring with SECONDARY_LANG_SCALING, so that
+// hits in the exact variant that rank just below the top DEFAULT_MAXHITS
+// before it's applied aren't lost.
+static const int CANDIDATE_HITS = 3 * DEFAULT_MAXHITS;
+
 
 void AddOrUpdateResult(SuggestionsList& all, Suggestion&& r)
 {
@@ -313,22 +496,306 @@ std::wstring get_text_field(DocumentPtr doc, const std::wstring& field)
 }
 
 
+// Normalized form of a text, with format placeholders and numbers replaced
+// with typed markers. Texts that differ only in the values of these, e.g.
+// "Page 3 of 10" and "Page 4 of 12" or "Deleted %d files" and "Deleted %s
+// files", have identical keys.
+struct NormalizedText
+{
+    enum TokenType
+    {
+        Placeholder = L'P',
+        Number = L'N'
+    };
+
+    /// Text with placeholders replaced by markers
+    std::wstring key;
+    /// Original values of the placeholders, in order of appearance
+    std::vector<std::wstring> tokens;
+
+    bool empty() const { return tokens.empty(); }
+};
+
+// Marker that can't occur in real text, used in normalized keys
+const wchar_t NORMALIZED_MARKER = L'\x01';
+
+inline bool is_ascii_digit(wchar_t c) { return c >= L'0' && c <= L'9'; }
+inline bool is_ascii_alnum(wchar_t c) { return is_ascii_digit(c) || (c >= L'a' && c <= L'z') || (c >= L'A' && c <= L'Z') || c == L'_'; }
+
+// Returns length of printf-style format specifier starting at text[pos], which
+// is '%', or 0 if there's none. Covers C/Python/Objective-C formats.
+size_t match_printf_placeholder(const std::wstring& text, size_t pos)
+{
+    const size_t len = text.length();
+    size_t i = pos + 1;
+    if (i >= len)
+        return 0;
+
+    if (text[i] == L'(') // Python's %(name)s
+    {
+        auto close = text.find(L')', i);
+        if (close == std::wstring::npos || close + 1 >= len)
+            return 0;
+        i = close + 1;
+    }
+    else
+    {
+        // positional argument, e.g. %1$s
+        size_t j = i;
+        while (j < len && is_ascii_digit(text[j]))
+            j++;
+        if (j > i && j < len && text[j] == L'$')
+            i = j + 1;
+    }
+
+    // flags (but not space, which would match too much ordinary text):
+    while (i < len && wcschr(L"-+#0'", text[i]))
+        i++;
+    // width:
+    if (i < len && text[i] == L'*')
+        i++;
+    else
+        while (i < len && is_ascii_digit(text[i]))
+            i++;
+    // precision:
+    if (i < len && text[i] == L'.')
+    {
+        i++;
+        if (i < len && text[i] == L'*')
+            i++;
+        else
+            while (i < len && is_ascii_digit(text[i]))
+                i++;
+    }
+    // length modifiers:
+    for (int n = 0; n < 2 && i < len && wcschr(L"hlLqjzt", text[i]); n++)
+        i++;
+
+    if (i < len && wcschr(L"diouxXeEfFgGaAcsSpn@", text[i]))
+        return i + 1 - pos;
+    return 0;
+}
+
+// Calls func(position, length, type) for every placeholder or number in the text
+template<typename F>
+void for_each_placeholder(const std::wstring& text, F&& func)
+{
+    const size_t len = text.length();
+    size_t i = 0;
+    while (i < len)
+    {
+        const wchar_t c = text[i];
+        size_t tokenLen = 0;
+        NormalizedText::TokenType type = NormalizedText::Placeholder;
+
+        if (c == L'%')
+        {
+            if (i + 1 < len && text[i + 1] == L'%')
+            {
+                i += 2; // escaped literal %
+                continue;
+            }
+            tokenLen = match_printf_placeholder(text, i);
+        }
+        else if (c == L'{')
+        {
+            // {0}, {name} etc.
+            size_t j = i + 1;
+            while (j < len && is_ascii_alnum(text[j]))
+                j++;
+            if (j > i + 1 && j < len && text[j] == L'}')
+                tokenLen = j + 1 - i;
+        }
+        else if (is_ascii_digit(c))
+        {
+            // numbers, including decimal and thousands separators between digits
+            size_t j = i;
+            while (j < len && is_ascii_digit(text[j]))
+            {
+                j++;
+                if (j + 1 < len && (text[j] == L'.' || text[j] == L',') && is_ascii_digit(text[j + 1]))
+                    j++;
+            }
+            tokenLen = j - i;
+            type = NormalizedText::Number;
+        }
+
+        if (tokenLen)
+        {
+            func(i, tokenLen, type);
+            i += tokenLen;
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+NormalizedText normalize_text(const std::wstring& text)
+{
+    NormalizedText out;
+    size_t last = 0;
+    for_each_placeholder(text, [&](size_t pos, size_t len, NormalizedText::TokenType type)
+    {
+        out.key.append(text, last, pos - last);
+        out.key += NORMALIZED_MARKER;
+        out.key += wchar_t(type);
+        out.tokens.push_back(text.substr(pos, len));
+        last = pos + len;
+    });
+    if (out.tokens.empty())
+        return NormalizedText();
+    out.key.append(text, last, std::wstring::npos);
+    return out;
+}
+
+// Adapts translation of a TM entry with source 'stored' to use placeholder
+// values from 'query', which has the same normalized key. Returns false if
+// this can't be done unambiguously.
+bool substitute_placeholders(const NormalizedText& stored, const NormalizedText& query, std::wstring& translation)
+{
+    if (stored.tokens.size() != query.tokens.size())
+        return false;
+
+    std::wstring out;
+    out.reserve(translation.length());
+    size_t last = 0;
+    bool ok = true;
+    for_each_placeholder(translation, [&](size_t pos, size_t len, NormalizedText::TokenType)
+    {
+        if (!ok)
+            return;
+        out.append(translation, last, pos - last);
+        last = pos + len;
+
+        auto value = translation.substr(pos, len);
+        const std::wstring *replacement = nullptr;
+        for (size_t i = 0; i < stored.tokens.size(); i++)
+        {
+            if (stored.tokens[i] != value)
+                continue;
+            if (replacement && *replacement != query.tokens[i])
+            {
+                ok = false; // e.g. "%d of %d" -> "%d of %s", can't tell which is which
+                return;
+            }
+            replacement = &query.tokens[i];
+        }
+        out += replacement ? *replacement : value;
+    });
+
+    if (!ok)
+        return false;
+
+    out.append(translation, last, std::wstring::npos);
+    translation.swap(out);
+    return true;
+}
+
+
+// Texts with fewer sentences than this aren't split into sub-segments
+const size_t MIN_SENTENCES_COUNT = 2;
+// Nor are very long texts, where aligning sentences by count is unreliable
+const size_t MAX_SENTENCES_COUNT = 20;
+
+// Score of a suggestion assembled from exact matches of individual sentences;
+// it's never 100%, because the sentences are aligned only heuristically
+const double SENTENCES_SCORE = 0.95;
+
+struct Sentence
+{
+    std::wstring text;
+    /// Whitespace that followed the sentence in the original text
+    std::wstring separator;
+};
+
+// Returns sentence iterator for the language. ICU iterators are expensive to
+// create, but aren't thread-safe, so they are cached per-thread.
+icu::BreakIterator *get_sentence_iterator(const Language& lang)
+{
+    thread_local std::map<std::string, std::unique_ptr<icu::BreakIterator>> s_iterators;
+
+    auto& iter = s_iterators[lang.IcuLocaleName()];
+    if (!iter)
+    {
+        UErrorCode err = U_ZERO_ERROR;
+        iter.reset(icu::BreakIterator::createSentenceInstance(lang.IsValid() ? lang.ToIcu() : icu::Locale::getEnglish(), err));
+        if (!iter || U_FAILURE(err))
+        {
+            err = U_ZERO_ERROR;
+            iter.reset(icu::BreakIterator::createSentenceInstance(icu::Locale::getEnglish(), err));
+        }
+    }
+    return iter.get();
+}
+
+// Whitespace that isn't part of sentences
+const wchar_t SENTENCE_WHITESPACE[] = L" \t\r\n\u00A0";
+
+std::vector<Sentence> split_sentences(const std::wstring& text, const Language& lang)
+{
+    std::vector<Sentence> out;
+
+    auto iter = get_sentence_iterator(lang);
+    if (!iter)
+        return out;
+
+    auto utext = str::to_icu(text);
+    iter->setText(utext);
+
+    int32_t start = iter->first();
+    for (int32_t end = iter->next(); end != icu::BreakIterator::DONE; start = end, end = iter->next())
+    {
+        auto piece = str::to_wstring(utext.tempSubStringBetween(start, end));
+        const size_t last = piece.find_last_not_of(SENTENCE_WHITESPACE);
+        if (last == std::wstring::npos)
+        {
+            // whitespace-only piece, e.g. blank line between paragraphs
+            if (!out.empty())
+                out.back().separator += piece;
+            continue;
+        }
+        // only the first sentence can have leading whitespace, whitespace
+        // before the others is part of the preceding piece:
+        const size_t first = piece.find_first_not_of(SENTENCE_WHITESPACE);
+        out.push_back({piece.substr(first, last + 1 - first), piece.substr(last + 1)});
+    }
+
+    return out;
+}
+
+// Adapts whitespace between sentences to the target language: Chinese and
+// Japanese don't separate sentences with spaces.
+std::wstring adapt_sentence_separator(const std::wstring& separator, const Language& lang)
+{
+    const auto l = lang.Lang();
+    if (l != "zh" && l != "ja")
+        return separator;
+
+    std::wstring out;
+    for (auto c: separator)
+    {
+        if (c == L'\n' || c == L'\r')
+            out += c;
+    }
+    return out;
+}
+
+
 template<typename T>
 void PerformSearchWithBlock(IndexSearcherPtr searcher,
-                            QueryPtr srclang, QueryPtr lang,
+                            FilterPtr langFilter,
+                            const Lucene::String& preferredLang,
                             const std::wstring& exactSourceText,
                             QueryPtr query,
                             double scoreThreshold,
                             double scoreScaling,
                             T callback)
 {
-    auto fullQuery = newLucene<BooleanQuery>();
-    fullQuery->add(srclang, BooleanClause::MUST);
-    fullQuery->add(lang, BooleanClause::MUST);
-    fullQuery->add(query, BooleanClause::MUST);
-
-    auto hits = searcher->search(fullQuery, DEFAULT_MAXHITS);
+    auto hits = searcher->search(query, langFilter, CANDIDATE_HITS);
 
+    std::vector<std::pair<DocumentPtr, double>> found;
     for (int i = 0; i < hits->scoreDocs.size(); i++)
     {
         const auto& scoreDoc = hits->scoreDocs[i];
@@ -356,14 +823,28 @@ void PerformSearchWithBlock(IndexSearcherPtr searcher,
             }
 
             score *= scoreScaling;
+
+            // prefer translations into the exact language variant:
+            if (doc->get(L"lang") != preferredLang)
+                score *= SECONDARY_LANG_SCALING;
         }
 
-        callback(doc, score);
+        found.emplace_back(doc, score);
     }
+
+    std::stable_sort(found.begin(), found.end(),
+                     [](const std::pair<DocumentPtr, double>& a, const std::pair<DocumentPtr, double>& b)
+                     { return a.second > b.second; });
+    if (found.size() > (size_t)DEFAULT_MAXHITS)
+        found.resize(DEFAULT_MAXHITS);
+
+    for (auto& f: found)
+        callback(f.first, f.second);
 }
 
 void PerformSearch(IndexSearcherPtr searcher,
-                   QueryPtr srclang, QueryPtr lang,
+                   FilterPtr langFilter,
+                   const Lucene::String& preferredLang,
                    const std::wstring& exactSourceText,
                    QueryPtr query,
                    SuggestionsList& results,
@@ -372,7 +853,7 @@ void PerformSearch(IndexSearcherPtr searcher,
 {
     PerformSearchWithBlock
     (
-        searcher, srclang, lang, exactSourceText, query,
+        searcher, langFilter, preferredLang, exactSourceText, query,
         scoreThreshold, scoreScaling,
         [&results](DocumentPtr doc, double score)
         {
@@ -389,34 +870,63 @@ void PerformSearch(IndexSearcherPtr searcher,
 
 } // anonymous namespace
 
+FilterPtr TranslationMemoryImpl::GetLanguageFilter(const Language& srclang, const Language& lang, bool withSegments)
+{
+    const Lucene::String fullLang = lang.WCode();
+    const std::wstring key = srclang.WCode() + L":" + fullLang + (withSegments ? L":segments" : L"");
+
+    std::lock_guard<std::mutex> guard(m_langFiltersMutex);
+    auto i = m_langFilters.find(key);
+    if (i != m_langFilters.end())
+        return i->second;
+
+    auto srclangQ = newLucene<TermQuery>(newLucene<Term>(L"srclang", srclang.WCode()));
+
+    const Lucene::String shortLang = StringUtils::toUnicode(lang.Lang());
+
+    QueryPtr langPrimary = newLucene<TermQuery>(newLucene<Term>(L"lang", fullLang));
+    QueryPtr langSecondary;
+    if (fullLang == shortLang)
+    {
+        // for e.g. 'cs', search also 'cs_*' (e.g. 'cs_CZ')
+        langSecondary = newLucene<PrefixQuery>(newLucene<Term>(L"lang", shortLang + L"_"));
+    }
+    else
+    {
+        // search short variants of the language too
+        langSecondary = newLucene<TermQuery>(newLucene<Term>(L"lang", shortLang));
+    }
+    auto langQ = newLucene<BooleanQuery>();
+    langQ->add(langPrimary, BooleanClause::SHOULD);
+    langQ->add(langSecondary, BooleanClause::SHOULD);
+
+    auto filterQ = newLucene<BooleanQuery>();
+    filterQ->add(srclangQ, BooleanClause::MUST);
+    filterQ->add(langQ, BooleanClause::MUST);
+    if (!withSegments)
+        filterQ->add(newLucene<TermQuery>(newLucene<Term>(L"segment", L"1")), BooleanClause::MUST_NOT);
+
+    // CachingWrapperFilter keeps the matching documents' bitset per segment
+    // reader, so reopened readers only compute it for new segments and
+    // segments merged away are dropped from the cache along with the reader:
+    FilterPtr filter = newLucene<CachingWrapperFilter>(newLucene<QueryWrapperFilter>(filterQ));
+    m_langFilters.emplace(key, filter);
+    return filter;
+}
+
+
 SuggestionsList TranslationMemoryImpl::Search(const Language& srclang,
                                               const Language& lang,
                                               const std::wstring& source)
 {
+    UsageGuard guard(*this);
+    if (!guard)
+        return SuggestionsList();
+
     try
     {
-        // TODO: query by srclang too!
-        auto srclangQ = newLucene<TermQuery>(newLucene<Term>(L"srclang", srclang.WCode()));
-
+        auto langFilter = GetLanguageFilter(srclang, lang, /*withSegments=*/false);
         const Lucene::String fullLang = lang.WCode();
-        const Lucene::String shortLang = StringUtils::toUnicode(lang.Lang());
-
-        QueryPtr langPrimary = newLucene<TermQuery>(newLucene<Term>(L"lang", fullLang));
-        QueryPtr langSecondary;
-        if (fullLang == shortLang)
-        {
-            // for e.g. 'cs', search also 'cs_*' (e.g. 'cs_CZ')
-            langSecondary = newLucene<PrefixQuery>(newLucene<Term>(L"lang", shortLang + L"_"));
-        }
-        else
-        {
-            // search short variants of the language too
-            langSecondary = newLucene<TermQuery>(newLucene<Term>(L"lang", shortLang));
-        }
-        langSecondary->setBoost(0.85);
-        auto langQ = newLucene<BooleanQuery>();
-        langQ->add(langPrimary, BooleanClause::SHOULD);
-        langQ->add(langSecondary, BooleanClause::SHOULD);
 
         SuggestionsList results;
 
@@ -439,15 +949,54 @@ SuggestionsList TranslationMemoryImpl::Search(const Language& srclang,
 
         auto searcher = m_mng->Searcher();
 
-        // Try exact phrase first:
-        PerformSearch(searcher.ptr(), srclangQ, langQ, source, phraseQ, results,
+        // Look for texts that only differ in placeholders or numbers first,
+        // because it's an inexpensive exact lookup:
+        auto normalized = normalize_text(source);
+        if (!normalized.empty())
+        {
+            auto normQ = newLucene<TermQuery>(newLucene<Term>(L"srcnorm", normalized.key));
+            PerformSearchWithBlock
+            (
+                searcher.ptr(), langFilter, fullLang, source, normQ,
+                /*scoreThreshold=*/0.0, /*scoreScaling=*/1.0,
+                [&](DocumentPtr doc, double)
+                {
+                    auto storedSource = normalize_text(get_text_field(doc, sourceField));
+                    auto t = get_text_field(doc, L"trans");
+                    if (storedSource.key != normalized.key || !substitute_placeholders(storedSource, normalized, t))
+                        return;
+                    time_t ts = DateField::stringToTime(doc->get(L"created"));
+                    Suggestion r {t, 1.0, int(ts)};
+                    r.id = StringUtils::toUTF8(doc->get(L"uuid"));
+                    AddOrUpdateResult(results, std::move(r));
+                }
+            );
+            if (!results.empty())
+            {
+                std::stable_sort(results.begin(), results.end());
+                return results;
+            }
+        }
+
+        // Then try exact phrase:
+        PerformSearch(searcher.ptr(), langFilter, fullLang, source, phraseQ, results,
                       QUALITY_THRESHOLD, /*scoreScaling=*/1.0);
         if (!results.empty())
             return results;
 
+        // Long texts often aren't in the TM as a whole, but their individual
+        // sentences are; exact lookups of them are much cheaper (and more
+        // useful) than the fuzzy searches below:
+        if (Config::TMSentenceSegments() &&
+            SearchBySentences(searcher.ptr(), GetLanguageFilter(srclang, lang, /*withSegments=*/true),
+                              fullLang, srclang, lang, source, results))
+        {
+            return results;
+        }
+
         // Then, if no matches were found, permit being a bit sloppy:
         phraseQ->setSlop(1);
-        PerformSearch(searcher.ptr(), srclangQ, langQ, source, phraseQ, results,
+        PerformSearch(searcher.ptr(), langFilter, fullLang, source, phraseQ, results,
                       QUALITY_THRESHOLD, /*scoreScaling=*/0.9);
 
         if (!results.empty())
@@ -458,7 +1007,7 @@ SuggestionsList TranslationMemoryImpl::Search(const Language& srclang,
         boolQ->setMinimumNumberShouldMatch(std::max(1, boolQ->getClauses().size() - MAX_ALLOWED_LENGTH_DIFFERENCE));
         PerformSearchWithBlock
         (
-            searcher.ptr(), srclangQ, langQ, source, boolQ,
+            searcher.ptr(), langFilter, fullLang, source, boolQ,
             QUALITY_THRESHOLD, /*scoreScaling=*/0.8,
             [=,&results](DocumentPtr doc, double score)
             {
@@ -489,8 +1038,112 @@ SuggestionsList TranslationMemoryImpl::Search(const Language& srclang,
 }
 
 
+bool TranslationMemoryImpl::FindExactTranslation(IndexSearcherPtr searcher,
+                                                 FilterPtr langFilter,
+                                                 const Lucene::String& preferredLang,
+                                                 const std::wstring& source,
+                                                 std::wstring& translation)
+{
+    const Lucene::String sourceField(L"source");
+
+    // use the most recent of exact matches, same as Search() would:
+    bool found = false;
+    time_t foundTime = 0;
+    auto useTranslation = [&](DocumentPtr doc, const std::wstring& t)
+    {
+        time_t ts = DateField::stringToTime(doc->get(L"created"));
+        if (!found || ts > foundTime)
+        {
+            translation = t;
+            foundTime = ts;
+            found = true;
+        }
+    };
+
+    auto normalized = normalize_text(source);
+    if (!normalized.empty())
+    {
+        auto normQ = newLucene<TermQuery>(newLucene<Term>(L"srcnorm", normalized.key));
+        PerformSearchWithBlock
+        (
+            searcher, langFilter, preferredLang, source, normQ,
+            /*scoreThreshold=*/0.0, /*scoreScaling=*/1.0,
+            [&](DocumentPtr doc, double)
+            {
+                auto storedSource = normalize_text(get_text_field(doc, sourceField));
+                auto t = get_text_field(doc, L"trans");
+                if (storedSource.key == normalized.key && substitute_placeholders(storedSource, normalized, t))
+                    useTranslation(doc, t);
+            }
+        );
+        if (found)
+            return true;
+    }
+
+    auto phraseQ = newLucene<PhraseQuery>();
+    auto stream = m_analyzer->tokenStream(sourceField, newLucene<StringReader>(source));
+    int tokensCount = 0;
+    int tokenPosition = -1;
+    while (stream->incrementToken())
+    {
+        tokensCount++;
+        auto word = stream->getAttribute<TermAttribute>()->term();
+        tokenPosition += stream->getAttribute<PositionIncrementAttribute>()->getPositionIncrement();
+        phraseQ->add(newLucene<Term>(sourceField, word), tokenPosition);
+    }
+    if (!tokensCount)
+        return false;
+
+    PerformSearchWithBlock
+    (
+        searcher, langFilter, preferredLang, source, phraseQ,
+        /*scoreThreshold=*/0.0, /*scoreScaling=*/1.0,
+        [&](DocumentPtr doc, double score)
+        {
+            // only identical source texts are scored as 1.0
+            if (score == 1.0)
+                useTranslation(doc, get_text_field(doc, L"trans"));
+        }
+    );
+
+    return found;
+}
+
+
+bool TranslationMemoryImpl::SearchBySentences(IndexSearcherPtr searcher,
+                                              FilterPtr langFilter,
+                                              const Lucene::String& preferredLang,
+                                              const Language& srclang, const Language& lang,
+                                              const std::wstring& source,
+                                              SuggestionsList& results)
+{
+    auto sentences = split_sentences(source, srclang);
+    if (sentences.size() < MIN_SENTENCES_COUNT || sentences.size() > MAX_SENTENCES_COUNT)
+        return false;
+
+    // the suggestion is only useful if every sentence is translated:
+    std::wstring composite = source.substr(0, source.find_first_not_of(SENTENCE_WHITESPACE));
+    for (auto& s: sentences)
+    {
+        std::wstring t;
+        if (!FindExactTranslation(searcher, langFilter, preferredLang, s.text, t))
+            return false;
+        composite += t;
+        composite += adapt_sentence_separator(s.separator, lang);
+    }
+
+    // NB: no ID, because there's no single TM entry to up/downvote
+    results.push_back(Suggestion(composite, SENTENCES_SCORE));
+    return true;
+}
+
+
 void TranslationMemoryImpl::ExportData(TranslationMemory::IOInterface& destination)
 {
+    UsageGuard guard(*this);
+    if (!guard)
+        throw Exception(_("Translation memory is closed."));
+
     try
     {
         auto reader = m_mng->Reader();
@@ -498,6 +1151,8 @@ void TranslationMemoryImpl::ExportData(TranslationMemory::IOInterface& destinati
         for (int32_t i = 0; i < numDocs; i++)
         {
             auto doc = reader->document(i);
+            if (!doc->get(L"segment").empty())
+                continue; // derived from another entry, not real data
             destination.Insert
             (
             	Language::TryParse(doc->get(L"srclang")),
@@ -512,80 +1167,596 @@ void TranslationMemoryImpl::ExportData(TranslationMemory::IOInterface& destinati
 }
 
 
-void TranslationMemoryImpl::ImportData(std::function<void(TranslationMemory::IOInterface&)> source)
-{
-    auto writer = TranslationMemory::Get().GetWriter();
-    source(*writer);
-    writer->Commit();
-}
-
-
 void TranslationMemoryImpl::GetStats(long& numDocs, long& fileSize)
 {
+    UsageGuard guard(*this);
+    if (!guard)
+        throw Exception(_("Translation memory is closed."));
+
     try
     {
         auto reader = m_mng->Reader();
         numDocs = reader->numDocs();
+        // don't count sentences derived from longer entries (approximately,
+        // because docFreq() includes deleted, but not yet merged, documents):
+        numDocs = std::max(0L, numDocs - (long)reader->docFreq(newLucene<Term>(L"segment", L"1")));
         fileSize = wxDir::GetTotalSize(GetDatabaseDir()).GetValue();
     }
     CATCH_AND_RETHROW_EXCEPTION
 }
 
-// ----------------------------------------------------------------
-// TranslationMemoryWriterImpl
-// ----------------------------------------------------------------
-
-class TranslationMemoryWriterImpl : public TranslationMemory::Writer
+namespace
 {
-public:
-    TranslationMemoryWriterImpl(IndexWriterPtr writer) : m_writer(writer) {}
 
-    ~TranslationMemoryWriterImpl() {}
+// Number of stored entries used as queries to measure search time
+const int PRUNE_SAMPLE_QUERIES = 20;
 
-    void Commit() override
-    {
-        try
-        {
-            m_writer->commit();
-        }
-        CATCH_AND_RETHROW_EXCEPTION
-    }
+const long SECONDS_PER_DAY = 24 * 60 * 60;
 
-    void Rollback() override
+} // anonymous namespace
+
+
+std::vector<TranslationMemoryImpl::SampleQuery> TranslationMemoryImpl::PickSampleQueries()
+{
+    std::vector<SampleQuery> samples;
+    try
     {
-        try
+        auto reader = m_mng->Reader();
+        const int32_t maxDoc = reader->maxDoc();
+        const int32_t step = std::max(1, maxDoc / PRUNE_SAMPLE_QUERIES);
+        for (int32_t i = 0; i < maxDoc && (int)samples.size() < PRUNE_SAMPLE_QUERIES; i += step)
         {
-            m_writer->rollback();
+            if (reader->isDeleted(i))
+                continue;
+            auto doc = reader->document(i);
+            if (!doc->get(L"segment").empty())
+                continue;
+            samples.push_back({Language::TryParse(doc->get(L"srclang")),
+                               Language::TryParse(doc->get(L"lang")),
+                               get_text_field(doc, L"source")});
         }
-        CATCH_AND_RETHROW_EXCEPTION
     }
+    CATCH_AND_RETHROW_EXCEPTION
 
-    void Insert(const Language& srclang, const Language& lang,
+    return samples;
+}
+
+
+double TranslationMemoryImpl::MeasureSearchTime(const std::vector<SampleQuery>& samples)
+{
+    if (samples.empty())
+        return 0;
+
+    // don't include reopening of the reader after changes in the measurement:
+    m_mng->Reader();
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto& q: samples)
+        Search(q.srclang, q.lang, q.source);
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    return elapsed.count() / samples.size();
+}
+
+
+TranslationMemory::PruneReport TranslationMemoryImpl::Prune(const TranslationMemory::RetentionPolicy& policy)
+{
+    TranslationMemory::PruneReport report;
+
+    UsageGuard guard(*this);
+    if (!guard)
+        return report;
+
+    std::lock_guard<std::mutex> lock(m_pruneMutex);
+
+    GetStats(report.numDocsBefore, report.fileSizeBefore);
+
+    const auto samples = PickSampleQueries();
+    report.searchTimeBefore = MeasureSearchTime(samples);
+
+    const time_t cutoff = policy.maxAgeDays > 0 ? time(NULL) - policy.maxAgeDays * SECONDS_PER_DAY : 0;
+
+    struct Entry
+    {
+        time_t created;
+        Lucene::String uuid;
+    };
+    std::map<Lucene::String, std::vector<Entry>> perLanguage;
+    std::vector<std::string> toDelete;
+
+    try
+    {
+        auto reader = m_mng->Reader();
+        const int32_t maxDoc = reader->maxDoc();
+        for (int32_t i = 0; i < maxDoc; i++)
+        {
+            if (m_shuttingDown)
+                return report;
+            if (reader->isDeleted(i))
+                continue;
+
+            auto doc = reader->document(i);
+            if (!doc->get(L"segment").empty())
+                continue; // derived from another entry, deleted together with it
+
+            auto uuid = doc->get(L"uuid");
+            const time_t created = DateField::stringToTime(doc->get(L"created"));
+
+            if (cutoff && created < cutoff)
+            {
+                toDelete.push_back(StringUtils::toUTF8(uuid));
+                report.removedByAge++;
+            }
+            else if (policy.knownSources && policy.knownSources->count(get_text_field(doc, L"source")) == 0)
+            {
+                toDelete.push_back(StringUtils::toUTF8(uuid));
+                report.removedUnused++;
+            }
+            else if (policy.maxEntriesPerLanguage > 0)
+            {
+                perLanguage[doc->get(L"lang")].push_back({created, uuid});
+            }
+        }
+    }
+    CATCH_AND_RETHROW_EXCEPTION
+
+    // keep only the newest entries in languages over the limit:
+    for (auto& lang: perLanguage)
+    {
+        auto& entries = lang.second;
+        if ((long)entries.size() <= policy.maxEntriesPerLanguage)
+            continue;
+        auto keepEnd = entries.begin() + policy.maxEntriesPerLanguage;
+        std::nth_element(entries.begin(), keepEnd, entries.end(),
+                         [](const Entry& a, const Entry& b){ return a.created > b.created; });
+        for (auto i = keepEnd; i != entries.end(); ++i)
+        {
+            toDelete.push_back(StringUtils::toUTF8(i->uuid));
+            report.removedByLimit++;
+        }
+    }
+
+    if (m_shuttingDown)
+        return report;
+
+    if (!toDelete.empty())
+    {
+        GetWriter()->Delete(toDelete);
+
+        try
+        {
+            // reclaim the space taken by deleted documents right away:
+            m_writer->expungeDeletes();
+        }
+        CATCH_AND_RETHROW_EXCEPTION
+
+        GetWriter()->Commit();
+    }
+
+    GetStats(report.numDocsAfter, report.fileSizeAfter);
+    report.searchTimeAfter = MeasureSearchTime(samples);
+
+    return report;
+}
+
+
+// ----------------------------------------------------------------
+// TranslationMemoryWriterImpl
+// ----------------------------------------------------------------
+
+namespace
+{
+
+// Calls func(source, translation) for every pair that should be stored in the
+// TM for given catalog item.
+template<typename F>
+void ForEachTMEntryInItem(const Language& lang, const CatalogItem& item, F&& func)
+{
+    // ignore translations with errors in them
+    if (item.HasError())
+        return;
+
+    // ignore untranslated or unfinished translations
+    if (item.IsFuzzy() || !item.IsTranslated())
+        return;
+
+    // always store at least the singular translation
+    func(str::to_wstring(item.GetString()), str::to_wstring(item.GetTranslation()));
+
+    // for plurals, try to support at least the simpler cases, with nplurals <= 2
+    if (item.HasPlural())
+    {
+        switch (lang.nplurals())
+        {
+            case 1:
+                // e.g. Chinese, Japanese; store translation for both singular and plural
+                func(str::to_wstring(item.GetPluralString()), str::to_wstring(item.GetTranslation()));
+                break;
+            case 2:
+                // e.g. Germanic or Romanic languages, same 2 forms as English
+                func(str::to_wstring(item.GetPluralString()), str::to_wstring(item.GetTranslation(1)));
+                break;
+            default:
+                // not supported, only singular stored above
+                break;
+        }
+    }
+}
+
+
+// Bloom filter parameters, giving ~1% false positives rate at capacity
+const size_t BLOOM_BITS_PER_ENTRY = 10;
+const int BLOOM_HASHES_COUNT = 7;
+const size_t BLOOM_MIN_CAPACITY = 100000;
+
+// Probabilistic set of strings: it may claim that a string is present
+// when it isn't (rarely), but never the other way around.
+class BloomFilter
+{
+public:
+    explicit BloomFilter(size_t expectedCount)
+        : m_capacity(std::max(expectedCount, BLOOM_MIN_CAPACITY)),
+          m_bits(m_capacity * BLOOM_BITS_PER_ENTRY),
+          m_count(0)
+    {}
+
+    void Add(const std::wstring& key)
+    {
+        ForEachBit(key, [=](size_t i){ m_bits[i] = true; });
+        m_count++;
+    }
+
+    bool MayContain(const std::wstring& key) const
+    {
+        bool all = true;
+        ForEachBit(key, [&](size_t i){ all = all && m_bits[i]; });
+        return all;
+    }
+
+    // False positives become too common if the filter holds many more
+    // items than it was sized for
+    bool IsOverfilled() const { return m_count > 2 * m_capacity; }
+
+private:
+    template<typename F>
+    void ForEachBit(const std::wstring& key, F&& func) const
+    {
+        // double hashing, see Kirsch & Mitzenmacher, "Less Hashing, Same Performance"
+        const size_t len = key.size() * sizeof(wchar_t);
+        const uint64_t h1 = fnv1a(key.data(), len);
+        const uint64_t h2 = fnv1a(key.data(), len, h1) | 1;
+        for (int i = 0; i < BLOOM_HASHES_COUNT; i++)
+            func((size_t)((h1 + i * h2) % m_bits.size()));
+    }
+
+    size_t m_capacity;
+    std::vector<bool> m_bits;
+    size_t m_count;
+};
+
+// Maximum number of entries added since the lookup snapshot was taken,
+// before it's taken anew (they are tracked in memory until then)
+const size_t MAX_ADDED_SINCE_SNAPSHOT = 50000;
+
+// Number of documents deleted with a single query; each contributes two
+// clauses and BooleanQuery is limited to 1024 of them by default
+const size_t DELETE_CHUNK_SIZE = 500;
+
+} // anonymous namespace
+
+
+class TranslationMemoryWriterImpl : public TranslationMemory::Writer
+{
+public:
+    TranslationMemoryWriterImpl(IndexWriterPtr writer, std::weak_ptr<SearcherManager> mng)
+        : m_writer(writer), m_mng(mng) {}
+
+    ~TranslationMemoryWriterImpl()
+    {
+        try
+        {
+            InvalidateLookupSnapshot();
+        }
+        catch (...) {}
+    }
+
+    void Commit() override
+    {
+        try
+        {
+            m_writer->commit();
+        }
+        CATCH_AND_RETHROW_EXCEPTION
+    }
+
+    void Rollback() override
+    {
+        try
+        {
+            std::lock_guard<std::mutex> lock(m_lookupMutex);
+            m_writer->rollback();
+            InvalidateLookupSnapshot();
+            MarkChanged(/*immediately=*/true);
+        }
+        CATCH_AND_RETHROW_EXCEPTION
+    }
+
+    void Insert(const Language& srclang, const Language& lang,
                 const std::wstring& source, const std::wstring& trans,
                 time_t creationTime) override
     {
+        InsertEntry(srclang, lang, source, trans, creationTime);
+    }
+
+    // Inserts a translation and returns what was done with it
+    TranslationMemory::InsertStats InsertEntry(const Language& srclang, const Language& lang,
+                                               const std::wstring& source, const std::wstring& trans,
+                                               time_t creationTime)
+    {
+        TranslationMemory::InsertStats stats;
         if (!lang.IsValid() || !srclang.IsValid() || lang == srclang)
-            return;
+            return stats;
 
         if (creationTime == 0)
             creationTime = time(NULL);
 
-        // Compute unique ID for the translation:
+        const std::wstring itemUUID = MakeUUID(srclang, lang, source, trans, L"");
+
+        bool exists;
+        {
+            std::lock_guard<std::mutex> lock(m_lookupMutex);
+
+            // The UUID is derived from the content, so an existing document is
+            // identical, except for its creation time; rewrite it only if that
+            // makes it newer, so that retention policies don't remove entries
+            // that are still being used:
+            time_t existingCreationTime = 0;
+            exists = FindExisting(itemUUID, existingCreationTime);
+            if (exists && creationTime <= existingCreationTime)
+            {
+                stats.skipped++;
+                return stats;
+            }
+        }
+
+        InsertDocument(itemUUID, srclang, lang, source, trans, creationTime, L"", exists);
+
+        {
+            // record the entry only once it was written, a failed write
+            // mustn't make later inserts of it be skipped as existing:
+            std::lock_guard<std::mutex> lock(m_lookupMutex);
+            m_addedSinceSnapshot[itemUUID] = creationTime;
+            if (!exists && m_knownUUIDs)
+                m_knownUUIDs->Add(itemUUID);
+        }
+
+        if (exists)
+            stats.updated++;
+        else
+            stats.added++;
+
+        // Store aligned sentences of multi-sentence texts too, so that texts
+        // differing only in some sentences can reuse the rest:
+        if (Config::TMSentenceSegments())
+        {
+            auto srcSentences = split_sentences(source, srclang);
+            if (srcSentences.size() >= MIN_SENTENCES_COUNT && srcSentences.size() <= MAX_SENTENCES_COUNT)
+            {
+                auto transSentences = split_sentences(trans, lang);
+                if (transSentences.size() == srcSentences.size())
+                {
+                    for (size_t i = 0; i < srcSentences.size(); i++)
+                    {
+                        auto& src = srcSentences[i].text;
+                        auto& tr = transSentences[i].text;
+                        // the same sentence may be used by several entries, each
+                        // needs its own copy so that it's deleted with it:
+                        InsertDocument(MakeUUID(srclang, lang, src, tr, L"segment" + itemUUID),
+                                       srclang, lang, src, tr, creationTime, itemUUID,
+                                       /*mayExist=*/true);
+                    }
+                }
+            }
+        }
+
+        return stats;
+    }
+
+    TranslationMemory::InsertStats Insert(const Language& srclang, const Language& lang,
+                                          const std::wstring& source, const std::wstring& trans) override
+    {
+        return InsertEntry(srclang, lang, source, trans, 0);
+    }
+
+    TranslationMemory::InsertStats Insert(const Language& srclang, const Language& lang, const CatalogItemPtr& item) override
+    {
+        TranslationMemory::InsertStats stats;
+        if (!lang.IsValid() || !srclang.IsValid())
+            return stats;
+
+        ForEachTMEntryInItem(lang, *item, [&](const std::wstring& source, const std::wstring& trans)
+        {
+            stats += Insert(srclang, lang, source, trans);
+        });
+        return stats;
+    }
+
+    TranslationMemory::InsertStats Insert(const CatalogPtr& cat) override
+    {
+        TranslationMemory::InsertStats stats;
+        auto srclang = cat->GetSourceLanguage();
+        auto lang = cat->GetLanguage();
+        if (!lang.IsValid() || !srclang.IsValid())
+            return stats;
+
+        for (auto& item: cat->items())
+        {
+            // Note that dt.IsModified() is intentionally not checked - we
+            // want to save old entries in the TM too, so that we harvest as
+            // much useful translations as we can.
+            stats += Insert(srclang, lang, item);
+        }
+        return stats;
+    }
+
+    void Delete(const std::string& uuid) override
+    {
+        try
+        {
+            std::lock_guard<std::mutex> lock(m_lookupMutex);
+            auto id = StringUtils::toUnicode(uuid);
+            m_writer->deleteDocuments(newLucene<Term>(L"uuid", id));
+            // ...and its sentences, if any:
+            m_writer->deleteDocuments(newLucene<Term>(L"parent", id));
+            InvalidateLookupSnapshot();
+            MarkChanged(/*immediately=*/true);
+        }
+        CATCH_AND_RETHROW_EXCEPTION
+    }
+
+    void Delete(const std::vector<std::string>& uuids) override
+    {
+        try
+        {
+            std::lock_guard<std::mutex> lock(m_lookupMutex);
+            for (size_t start = 0; start < uuids.size(); start += DELETE_CHUNK_SIZE)
+            {
+                const size_t end = std::min(uuids.size(), start + DELETE_CHUNK_SIZE);
+                auto query = newLucene<BooleanQuery>();
+                for (size_t i = start; i < end; i++)
+                {
+                    auto id = StringUtils::toUnicode(uuids[i]);
+                    query->add(newLucene<TermQuery>(newLucene<Term>(L"uuid", id)), BooleanClause::SHOULD);
+                    // ...and its sentences, if any:
+                    query->add(newLucene<TermQuery>(newLucene<Term>(L"parent", id)), BooleanClause::SHOULD);
+                }
+                m_writer->deleteDocuments(query);
+            }
+            InvalidateLookupSnapshot();
+            MarkChanged(/*immediately=*/true);
+        }
+        CATCH_AND_RETHROW_EXCEPTION
+    }
+
+    void DeleteAll() override
+    {
+        try
+        {
+            std::lock_guard<std::mutex> lock(m_lookupMutex);
+            m_writer->deleteAll();
+            InvalidateLookupSnapshot();
+            m_knownUUIDs.reset();
+            MarkChanged(/*immediately=*/true);
+        }
+        CATCH_AND_RETHROW_EXCEPTION
+    }
+
+    // Makes the changes visible to searches; unless @a immediately is set,
+    // SearcherManager may delay it a bit (see REOPEN_MIN_INTERVAL)
+    void MarkChanged(bool immediately = false)
+    {
+        if (auto mng = m_mng.lock())
+            mng->MarkChanged(immediately);
+    }
 
+private:
+    // Computes unique ID for the translation
+    static std::wstring MakeUUID(const Language& srclang, const Language& lang,
+                                 const std::wstring& source, const std::wstring& trans,
+                                 const std::wstring& kind)
+    {
         static const boost::uuids::uuid s_namespace =
           boost::uuids::string_generator()("6e3f73c5-333f-4171-9d43-954c372a8a02");
         boost::uuids::name_generator gen(s_namespace);
 
-        std::wstring itemId(srclang.WCode());
+        std::wstring itemId(kind);
+        itemId += srclang.WCode();
         itemId += lang.WCode();
         itemId += source;
         itemId += trans;
 
-        const std::wstring itemUUID = boost::uuids::to_wstring(gen(itemId));
+        return boost::uuids::to_wstring(gen(itemId));
+    }
 
+    // Checks whether a document with given UUID is stored and if it is, gets
+    // its creation time.
+    // contract: m_lookupMutex is locked when this function is called
+    bool FindExisting(const std::wstring& uuid, time_t& creationTime)
+    {
+        try
+        {
+            if (!m_lookupReader || m_addedSinceSnapshot.size() > MAX_ADDED_SINCE_SNAPSHOT)
+            {
+                InvalidateLookupSnapshot();
+                m_lookupReader = m_writer->getReader();
+            }
+
+            if (!m_knownUUIDs || m_knownUUIDs->IsOverfilled())
+            {
+                m_knownUUIDs.reset(new BloomFilter(2 * (size_t)m_lookupReader->maxDoc()));
+                auto terms = m_lookupReader->terms(newLucene<Term>(L"uuid", L""));
+                do
+                {
+                    auto t = terms->term();
+                    if (!t || t->field() != L"uuid")
+                        break;
+                    m_knownUUIDs->Add(t->text());
+                } while (terms->next());
+                terms->close();
+            }
+
+            // Most entries of imported data are new, so this avoids the
+            // expensive lookup in the index in the common case:
+            if (!m_knownUUIDs->MayContain(uuid))
+                return false;
+
+            auto added = m_addedSinceSnapshot.find(uuid);
+            if (added != m_addedSinceSnapshot.end())
+            {
+                creationTime = added->second;
+                return true;
+            }
+
+            auto termDocs = m_lookupReader->termDocs(newLucene<Term>(L"uuid", uuid));
+            const bool found = termDocs->next();
+            const int32_t docId = found ? termDocs->doc() : -1;
+            termDocs->close();
+            if (!found)
+                return false;
+
+            static const auto s_createdOnly = newLucene<MapFieldSelector>(newCollection<String>(L"created"));
+            auto doc = m_lookupReader->document(docId, s_createdOnly);
+            creationTime = DateField::stringToTime(doc->get(L"created"));
+            return true;
+        }
+        CATCH_AND_RETHROW_EXCEPTION
+    }
+
+    // Drops the reader used by FindExisting(); must be called after deleting
+    // documents, because it wouldn't reflect that.
+    // contract: m_lookupMutex is locked when this function is called
+    void InvalidateLookupSnapshot()
+    {
+        if (m_lookupReader)
+        {
+            m_lookupReader->close();
+            m_lookupReader.reset();
+        }
+        m_addedSinceSnapshot.clear();
+    }
+
+    // Adds a document to the index; parentUUID is set for sentences
+    // extracted from a longer text. If the document can't already exist,
+    // it's added without trying to delete the old version first.
+    void InsertDocument(const std::wstring& itemUUID,
+                        const Language& srclang, const Language& lang,
+                        const std::wstring& source, const std::wstring& trans,
+                        time_t creationTime,
+                        const std::wstring& parentUUID,
+                        bool mayExist)
+    {
         try
         {
-            // Then add a new document:
             auto doc = newLucene<Document>();
 
             doc->add(newLucene<Field>(L"uuid", itemUUID,
@@ -603,90 +1774,368 @@ public:
             doc->add(newLucene<Field>(L"trans", trans,
                                       Field::STORE_YES, Field::INDEX_NOT_ANALYZED));
 
-            m_writer->updateDocument(newLucene<Term>(L"uuid", itemUUID), doc);
+            // normalized key for placeholder-insensitive exact lookups:
+            auto normalized = normalize_text(source);
+            if (!normalized.empty())
+            {
+                doc->add(newLucene<Field>(L"srcnorm", normalized.key,
+                                          Field::STORE_NO, Field::INDEX_NOT_ANALYZED_NO_NORMS));
+            }
+
+            // sentences are derived data, they are deleted with their parent
+            // and not exported:
+            if (!parentUUID.empty())
+            {
+                doc->add(newLucene<Field>(L"segment", L"1",
+                                          Field::STORE_YES, Field::INDEX_NOT_ANALYZED_NO_NORMS));
+                doc->add(newLucene<Field>(L"parent", parentUUID,
+                                          Field::STORE_NO, Field::INDEX_NOT_ANALYZED_NO_NORMS));
+            }
+
+            if (mayExist)
+                m_writer->updateDocument(newLucene<Term>(L"uuid", itemUUID), doc);
+            else
+                m_writer->addDocument(doc);
+            MarkChanged();
         }
         CATCH_AND_RETHROW_EXCEPTION
     }
 
-    void Insert(const Language& srclang, const Language& lang,
-                const std::wstring& source, const std::wstring& trans) override
+    IndexWriterPtr m_writer;
+    std::weak_ptr<SearcherManager> m_mng;
+
+    // Lookups of existing documents, see FindExisting(). The reader is a
+    // snapshot, documents written since it was taken are tracked separately.
+    std::mutex m_lookupMutex;
+    std::unique_ptr<BloomFilter> m_knownUUIDs;
+    IndexReaderPtr m_lookupReader;
+    std::unordered_map<std::wstring, time_t> m_addedSinceSnapshot;
+};
+
+
+
+// ----------------------------------------------------------------
+// TranslationMemoryInsertQueue
+// ----------------------------------------------------------------
+
+// Queue of interactive inserts (i.e. done as the user translates) that are
+// written in batches by a single background thread. This avoids a stream of
+// tiny concurrent writes competing for the writer and forcing readers to be
+// reopened after each of them.
+class TranslationMemoryInsertQueue
+{
+public:
+    TranslationMemoryInsertQueue(std::shared_ptr<TranslationMemoryWriterImpl> writer)
+        : m_writer(writer),
+          m_stop(false), m_flushRequested(false),
+          m_enqueuedSeq(0), m_writtenSeq(0),
+          m_uncommitted(0),
+          m_lastCommit(std::chrono::steady_clock::now()),
+          m_errorReported(false)
     {
-        Insert(srclang, lang, source, trans, 0);
+        m_thread = std::thread([=]{ ThreadMain(); });
     }
 
-    void Insert(const Language& srclang, const Language& lang, const CatalogItemPtr& item) override
+    ~TranslationMemoryInsertQueue()
     {
-        if (!lang.IsValid() || !srclang.IsValid())
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wakeWriter.notify_all();
+        m_thread.join();
+    }
+
+    void Enqueue(const Language& srclang, const Language& lang, const CatalogItemPtr& item)
+    {
+        if (!lang.IsValid() || !srclang.IsValid() || lang == srclang)
             return;
 
-        // ignore translations with errors in them
-        if (item->HasError())
+        // Copy the data now, on the caller's thread, the item may change later:
+        Entry e { item, srclang, lang, {} };
+        ForEachTMEntryInItem(lang, *item, [&e](const std::wstring& source, const std::wstring& trans)
+        {
+            e.texts.emplace_back(source, trans);
+        });
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        // Newer edit of a still-queued item replaces the old one, even if it
+        // means nothing will be written (e.g. the entry was made fuzzy since).
+        auto existing = std::find_if(m_queue.begin(), m_queue.end(), [&e](const Entry& x)
+        {
+            return x.item == e.item && x.srclang == e.srclang && x.lang == e.lang;
+        });
+        if (existing != m_queue.end())
+        {
+            existing->texts = std::move(e.texts);
             return;
+        }
+
+        if (e.texts.empty())
+            return;
+
+        // Never block the caller (i.e. the UI) if the writer can't keep up;
+        // dropping the entry is harmless, because the whole catalog is
+        // written into the TM when it's saved anyway.
+        if (m_queue.size() >= MAX_QUEUED)
+        {
+            wxLogTrace("poedit.tm", "insert queue is full, dropping entry");
+            return;
+        }
 
-        // ignore untranslated or unfinished translations
-        if (item->IsFuzzy() || !item->IsTranslated())
+        m_queue.push_back(std::move(e));
+        m_enqueuedSeq++;
+
+        if (m_queue.size() >= BATCH_SIZE)
+            m_wakeWriter.notify_one();
+        else if (m_queue.size() == 1)
+            m_wakeWriter.notify_one(); // start measuring batch delay
+    }
+
+    void Flush()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        const auto target = m_enqueuedSeq;
+        if (m_writtenSeq >= target)
             return;
 
-        // always store at least the singular translation
-        Insert(srclang, lang, str::to_wstring(item->GetString()), str::to_wstring(item->GetTranslation()));
+        m_flushRequested = true;
+        m_wakeWriter.notify_one();
+        m_wakeProducers.wait(lock, [=]{ return m_writtenSeq >= target; });
+    }
 
-        // for plurals, try to support at least the simpler cases, with nplurals <= 2
-        if (item->HasPlural())
+private:
+    struct Entry
+    {
+        CatalogItemPtr item;
+        Language srclang, lang;
+        std::vector<std::pair<std::wstring, std::wstring>> texts;
+    };
+
+    // Max. number of queued items, more are dropped
+    static const size_t MAX_QUEUED = 1000;
+    // Number of items that is written immediately, without waiting for more
+    static const size_t BATCH_SIZE = 64;
+    // Max. time to wait for more items to group into a batch
+    static constexpr std::chrono::milliseconds BATCH_DELAY{500};
+    // Number of written, but uncommitted entries that triggers a commit.
+    // Written entries are searchable even without committing, so commits
+    // are only needed for durability and can be done rarely:
+    static const size_t COMMIT_THRESHOLD = 2000;
+    // Max. time since the last commit before written entries are committed
+    static constexpr std::chrono::minutes COMMIT_INTERVAL{10};
+
+    void ThreadMain()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;)
         {
-            switch (lang.nplurals())
+            if (m_queue.empty())
             {
-                case 1:
-                    // e.g. Chinese, Japanese; store translation for both singular and plural
-                    Insert(srclang, lang, str::to_wstring(item->GetPluralString()), str::to_wstring(item->GetTranslation()));
-                    break;
-                case 2:
-                    // e.g. Germanic or Romanic languages, same 2 forms as English
-                    Insert(srclang, lang, str::to_wstring(item->GetPluralString()), str::to_wstring(item->GetTranslation(1)));
-                    break;
-                default:
-                    // not supported, only singular stored above
+                if (m_stop)
                     break;
+                m_wakeWriter.wait(lock);
+                continue;
             }
+
+            // wait a bit for more items, to write them together:
+            m_wakeWriter.wait_for(lock, BATCH_DELAY, [=]{
+                return m_queue.size() >= BATCH_SIZE || m_flushRequested || m_stop;
+            });
+
+            std::vector<Entry> batch;
+            batch.swap(m_queue);
+            const auto seq = m_enqueuedSeq;
+            m_flushRequested = false;
+
+            lock.unlock();
+            WriteBatch(batch);
+            lock.lock();
+
+            m_writtenSeq = seq;
+            m_wakeProducers.notify_all();
         }
     }
 
-    void Insert(const CatalogPtr& cat) override
+    void WriteBatch(const std::vector<Entry>& batch)
     {
-        auto srclang = cat->GetSourceLanguage();
-        auto lang = cat->GetLanguage();
-        if (!lang.IsValid() || !srclang.IsValid())
-            return;
+        // contract: called on the writer thread without m_mutex locked
+        try
+        {
+            for (auto& e: batch)
+            {
+                for (auto& t: e.texts)
+                    m_writer->Insert(e.srclang, e.lang, t.first, t.second);
+                m_uncommitted += e.texts.size();
+            }
 
-        for (auto& item: cat->items())
+            // just confirmed entries must be found by the next search, the
+            // batching above already limits how often the reader is reopened:
+            m_writer->MarkChanged(/*immediately=*/true);
+
+            const auto now = std::chrono::steady_clock::now();
+            if (m_uncommitted >= COMMIT_THRESHOLD || now - m_lastCommit >= COMMIT_INTERVAL)
+            {
+                m_writer->Commit();
+                m_uncommitted = 0;
+                m_lastCommit = now;
+            }
+        }
+        catch (const Exception& e)
         {
-            // Note that dt.IsModified() is intentionally not checked - we
-            // want to save old entries in the TM too, so that we harvest as
-            // much useful translations as we can.
-            Insert(srclang, lang, item);
+            // the data will be written again when saving the file, so it's
+            // enough to tell the user about the problem once:
+            if (!m_errorReported)
+            {
+                m_errorReported = true;
+                wxLogError(_("Failed to write to translation memory: %s"), e.What());
+            }
         }
     }
 
-    void Delete(const std::string& uuid) override
+    std::shared_ptr<TranslationMemoryWriterImpl> m_writer;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wakeWriter, m_wakeProducers;
+    std::vector<Entry> m_queue;
+    bool m_stop, m_flushRequested;
+    uint64_t m_enqueuedSeq, m_writtenSeq;
+    // only accessed from the writer thread:
+    size_t m_uncommitted;
+    std::chrono::steady_clock::time_point m_lastCommit;
+    bool m_errorReported;
+
+    std::thread m_thread;
+};
+
+constexpr std::chrono::milliseconds TranslationMemoryInsertQueue::BATCH_DELAY;
+constexpr std::chrono::minutes TranslationMemoryInsertQueue::COMMIT_INTERVAL;
+
+
+std::shared_ptr<TranslationMemory::Writer> TranslationMemoryImpl::GetWriter()
+{
+    // NB: no UsageGuard needed, the writer object outlives Shutdown() and
+    //     only reports errors when used after the index was closed
+    return m_writerAPI;
+}
+
+
+TranslationMemory::InsertStats TranslationMemoryImpl::ImportData(std::function<void(TranslationMemory::IOInterface&)> source)
+{
+    // Count what is done with the imported entries here, rather than in the
+    // shared writer, which may be used by other inserts at the same time:
+    class Importer : public TranslationMemory::IOInterface
     {
-        try
+    public:
+        Importer(TranslationMemoryWriterImpl& writer) : m_writer(writer) {}
+
+        void Insert(const Language& srclang, const Language& lang,
+                    const std::wstring& source, const std::wstring& trans,
+                    time_t creationTime) override
         {
-            m_writer->deleteDocuments(newLucene<Term>(L"uuid", StringUtils::toUnicode(uuid)));
+            stats += m_writer.InsertEntry(srclang, lang, source, trans, creationTime);
         }
-        CATCH_AND_RETHROW_EXCEPTION
-    }
 
-    void DeleteAll() override
+        TranslationMemory::InsertStats stats;
+
+    private:
+        TranslationMemoryWriterImpl& m_writer;
+    };
+
+    UsageGuard guard(*this);
+    if (!guard)
+        throw Exception(_("Translation memory is closed."));
+
+    Importer importer(*m_writerAPI);
+    source(importer);
+    m_writerAPI->Commit();
+    return importer.stats;
+}
+
+
+void TranslationMemoryImpl::InsertAsync(const Language& srclang, const Language& lang, const CatalogItemPtr& item)
+{
+    UsageGuard guard(*this);
+    if (guard)
+        m_insertQueue->Enqueue(srclang, lang, item);
+}
+
+
+void TranslationMemoryImpl::FlushQueuedInserts()
+{
+    UsageGuard guard(*this);
+    if (guard)
+        m_insertQueue->Flush();
+}
+
+
+namespace
+{
+
+// How many of the catalog's untranslated strings to run as warm-up queries
+const size_t WARMUP_SAMPLES_COUNT = 3;
+
+} // anonymous namespace
+
+void TranslationMemoryImpl::WarmUp(const Language& srclang, const Language& lang,
+                                   const std::vector<std::wstring>& samples)
+{
+    UsageGuard guard(*this);
+    if (!guard)
+        return;
+
+    try
     {
-        try
+        auto start = std::chrono::steady_clock::now();
+
         {
-            m_writer->deleteAll();
+            auto reader = m_mng->Reader();
+
+            // Touch term dictionaries of all queried fields. For the language
+            // fields, look up the very terms that searches will need:
+            reader->docFreq(newLucene<Term>(L"srclang", srclang.WCode()));
+            reader->docFreq(newLucene<Term>(L"lang", lang.WCode()));
+            reader->docFreq(newLucene<Term>(L"lang", StringUtils::toUnicode(lang.Lang())));
+            for (auto field: {L"source", L"srcnorm"})
+            {
+                auto terms = reader->terms(newLucene<Term>(field, L""));
+                terms->close();
+            }
+
+            // Norms are loaded lazily, on first scoring of the field. Searches
+            // score each segment separately, using its own norms, so load them
+            // for every segment rather than the top-level reader's merged copy:
+            auto segments = reader->getSequentialSubReaders();
+            if (!segments)
+                segments = newCollection<IndexReaderPtr>(reader.ptr()); // single segment
+            for (auto segment: segments)
+            {
+                if (m_shuttingDown)
+                    return;
+                if (segment->hasNorms(L"source"))
+                    segment->norms(L"source");
+            }
         }
-        CATCH_AND_RETHROW_EXCEPTION
-    }
 
-private:
-    IndexWriterPtr m_writer;
-};
+        // Run some queries to get the rest of the code paths (and the
+        // searched parts of the index) warm too:
+        for (auto& s: samples)
+        {
+            if (m_shuttingDown)
+                return;
+            Search(srclang, lang, s);
+        }
+
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        wxLogTrace("poedit.tm", "warm-up for %s -> %s took %d ms",
+                   srclang.Code(), lang.Code(), (int)duration.count());
+    }
+    catch (...)
+    {
+        // it's only an optimization, errors will be reported by real searches
+    }
+}
 
 
 void TranslationMemoryImpl::Init()
@@ -702,7 +2151,8 @@ void TranslationMemoryImpl::Init()
         // get the associated realtime reader & searcher:
         m_mng.reset(new SearcherManager(m_writer));
 
-        m_writerAPI = std::make_shared<TranslationMemoryWriterImpl>(m_writer);
+        m_writerAPI = std::make_shared<TranslationMemoryWriterImpl>(m_writer, m_mng);
+        m_insertQueue.reset(new TranslationMemoryInsertQueue(m_writerAPI));
     }
     CATCH_AND_RETHROW_EXCEPTION
 }
@@ -733,11 +2183,11 @@ void TranslationMemory::CleanUp()
     }
 }
 
-TranslationMemory::TranslationMemory() : m_impl(nullptr)
+TranslationMemory::TranslationMemory()
 {
     try
     {
-        m_impl = new TranslationMemoryImpl;
+        m_impl = std::make_shared<TranslationMemoryImpl>();
     }
     catch (...)
     {
@@ -745,7 +2195,31 @@ TranslationMemory::TranslationMemory() : m_impl(nullptr)
     }
 }
 
-TranslationMemory::~TranslationMemory() { delete m_impl; }
+TranslationMemory::~TranslationMemory()
+{
+    // background operations may still hold references to the implementation,
+    // make sure they finish before the database is closed:
+    if (m_impl)
+        m_impl->Shutdown();
+}
+
+std::shared_ptr<TranslationMemoryImpl> TranslationMemory::GetImpl()
+{
+    std::unique_lock<std::mutex> lock(m_implMutex);
+    if (!m_impl)
+    {
+        auto error = m_error;
+        lock.unlock();
+        std::rethrow_exception(error);
+    }
+    return m_impl;
+}
+
+std::shared_ptr<TranslationMemoryImpl> TranslationMemory::TryGetImpl()
+{
+    std::lock_guard<std::mutex> lock(m_implMutex);
+    return m_impl;
+}
 
 
 // ----------------------------------------------------------------
@@ -756,9 +2230,7 @@ SuggestionsList TranslationMemory::Search(const Language& srclang,
                                           const Language& lang,
                                           const std::wstring& source)
 {
-    if (!m_impl)
-        std::rethrow_exception(m_error);
-    return m_impl->Search(srclang, lang, source);
+    return GetImpl()->Search(srclang, lang, source);
 }
 
 dispatch::future<SuggestionsList> TranslationMemory::SuggestTranslation(const SuggestionQuery&& q)
@@ -782,23 +2254,64 @@ void TranslationMemory::Delete(const std::string& id)
 
 void TranslationMemory::ExportData(IOInterface& destination)
 {
-    if (!m_impl)
-        std::rethrow_exception(m_error);
-    return m_impl->ExportData(destination);
+    return GetImpl()->ExportData(destination);
 }
 
-void TranslationMemory::ImportData(std::function<void(IOInterface&)> source)
+TranslationMemory::InsertStats TranslationMemory::ImportData(std::function<void(IOInterface&)> source)
 {
-    if (!m_impl)
-        std::rethrow_exception(m_error);
-    return m_impl->ImportData(source);
+    return GetImpl()->ImportData(source);
 }
 
 std::shared_ptr<TranslationMemory::Writer> TranslationMemory::GetWriter()
 {
-    if (!m_impl)
-        std::rethrow_exception(m_error);
-    return m_impl->GetWriter();
+    return GetImpl()->GetWriter();
+}
+
+void TranslationMemory::InsertAsync(const Language& srclang, const Language& lang, const CatalogItemPtr& item)
+{
+    if (auto impl = TryGetImpl())
+        impl->InsertAsync(srclang, lang, item);
+}
+
+void TranslationMemory::FlushQueuedInserts()
+{
+    if (auto impl = TryGetImpl())
+        impl->FlushQueuedInserts();
+}
+
+void TranslationMemory::WarmUpAsync(CatalogPtr catalog)
+{
+    // Get the instance here, not in the background job: the job may run when
+    // the app is already exiting and CleanUp() was called. The reference keeps
+    // the implementation alive and its UsageGuard makes shutdown wait for it.
+    auto impl = Get().TryGetImpl();
+    if (!impl)
+        return;
+
+    auto srclang = catalog->GetSourceLanguage();
+    auto lang = catalog->GetLanguage();
+    // Only copy the (shared) item pointers here, the catalog may be modified
+    // on the calling thread while the scan is running:
+    auto items = catalog->items();
+
+    dispatch::async([=]
+    {
+        std::vector<std::wstring> samples;
+        for (auto& item: items)
+        {
+            if (samples.size() == WARMUP_SAMPLES_COUNT)
+                break;
+            if (!item->IsTranslated())
+                samples.push_back(item->GetString().ToStdWstring());
+        }
+
+        impl->WarmUp(srclang, lang, samples);
+    });
+}
+
+TranslationMemory::PruneReport TranslationMemory::Prune(const RetentionPolicy& policy)
+{
+    return GetImpl()->Prune(policy);
 }
 
 void TranslationMemory::DeleteAllAndReset()
@@ -811,20 +2324,37 @@ void TranslationMemory::DeleteAllAndReset()
     }
     catch (...)
     {
-        // Lucene database is corrupted, best we can do is delete it completely
+        // Lucene database is corrupted, best we can do is delete it completely,
+        // but only after everything using it was stopped:
+        std::shared_ptr<TranslationMemoryImpl> old;
+        {
+            std::lock_guard<std::mutex> lock(m_implMutex);
+            old.swap(m_impl);
+        }
+        if (old)
+            old->Shutdown();
+
         wxFileName::Rmdir(TranslationMemoryImpl::GetDatabaseDir(), wxPATH_RMDIR_RECURSIVE);
 
         // recreate implementation object
-        TranslationMemoryImpl *impl = new TranslationMemoryImpl;
-        std::swap(m_impl, impl);
-        delete impl;
+        std::shared_ptr<TranslationMemoryImpl> impl;
+        try
+        {
+            impl = std::make_shared<TranslationMemoryImpl>();
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(m_implMutex);
+            m_error = std::current_exception();
+            throw;
+        }
+        std::lock_guard<std::mutex> lock(m_implMutex);
+        m_impl = impl;
         m_error = nullptr;
     }
 }
 
 void TranslationMemory::GetStats(long& numDocs, long& fileSize)
 {
-    if (!m_impl)
-        std::rethrow_exception(m_error);
-    m_impl->GetStats(numDocs, fileSize);
+    GetImpl()->GetStats(numDocs, fileSize);
 }
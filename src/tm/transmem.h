@@ -31,6 +31,8 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <mutex>
+#include <unordered_set>
 
 #include "catalog.h"
 #include "suggestions.h"
@@ -69,6 +71,25 @@ public:
 
     void Delete(const std::string& id) override;
 
+    /// Counts of entries written into the TM
+    struct InsertStats
+    {
+        /// New entries
+        long added = 0;
+        /// Existing entries that were rewritten to refresh their creation time
+        long updated = 0;
+        /// Entries that were already stored, unchanged, and were skipped
+        long skipped = 0;
+
+        InsertStats& operator+=(const InsertStats& other)
+        {
+            added += other.added;
+            updated += other.updated;
+            skipped += other.skipped;
+            return *this;
+        }
+    };
+
     /// Abstract interface to processing TM entries
     class IOInterface
     {
@@ -93,9 +114,9 @@ public:
         Imports data provided by the function into the database. The function
         must use the interface passed to it to write data.
 
-        May throw on error.
+        Returns counts of added, updated and skipped entries. May throw on error.
      */
-    void ImportData(std::function<void(IOInterface&)> source);
+    InsertStats ImportData(std::function<void(IOInterface&)> source);
 
 
     /**
@@ -104,7 +125,13 @@ public:
         Call Commit() to commit changes since the last commit to disk.
         Call Rollback() to undo all changes since the last commit.
         
-        Committing shouldn't be done too often, as it is expensive.
+        Committing shouldn't be done too often, as it is expensive. It is
+        only needed for durability: written changes are visible to Search()
+        right away, without committing them first.
+
+        Inserting an entry that is already stored is cheap: it is detected
+        (using an in-memory Bloom filter of stored entries' IDs, backed by
+        index lookups) and skipped instead of being rewritten.
         The writer is shared and can be used by multiple threads.
         
         Note that closing the writer on shutdown, if it has uncommitted
@@ -131,11 +158,13 @@ public:
             @param lang    Translation language.
             @param source  Source text.
             @param trans   Translation text.
+
+            @return Counts of what was done with the entry.
          */
-        virtual void Insert(const Language& srclang,
-                            const Language& lang,
-                            const std::wstring& source,
-                            const std::wstring& trans) = 0;
+        virtual InsertStats Insert(const Language& srclang,
+                                   const Language& lang,
+                                   const std::wstring& source,
+                                   const std::wstring& trans) = 0;
 
         /**
             Inserts a single catalog item.
@@ -143,9 +172,9 @@ public:
             @note
             Not everything is included: fuzzy or untranslated entries are skipped.
          */
-        virtual void Insert(const Language& srclang,
-                            const Language& lang,
-                            const CatalogItemPtr& item) = 0;
+        virtual InsertStats Insert(const Language& srclang,
+                                   const Language& lang,
+                                   const CatalogItemPtr& item) = 0;
 
         /**
             Inserts entire content of the catalog.
@@ -154,11 +183,14 @@ public:
             Not everything is included: fuzzy or untranslated entries are omitted.
             If the catalog doesn't have language header, it is not included either.
          */
-        virtual void Insert(const CatalogPtr& cat) = 0;
+        virtual InsertStats Insert(const CatalogPtr& cat) = 0;
 
         /// Delete a single document identifed by its UUID
         virtual void Delete(const std::string& uuid) = 0;
 
+        /// Deletes many documents at once, much faster than one by one
+        virtual void Delete(const std::vector<std::string>& uuids) = 0;
+
         /// Deletes everything from the TM.
         virtual void DeleteAll() = 0;
 
@@ -172,6 +204,76 @@ public:
     /// Returns the shared writer instance
     std::shared_ptr<Writer> GetWriter();
 
+    /**
+        Asynchronously inserts a single catalog item into the TM.
+
+        Intended for interactive use, i.e. as the user translates. The item
+        is only queued and written later, in batches, by a single background
+        thread. Repeated edits of the same item that weren't written yet are
+        coalesced. Fuzzy, untranslated or invalid entries are skipped the
+        same way Writer::Insert() does it.
+
+        Unlike other methods, this one never throws. The item's content is
+        copied, so it may be modified immediately after the call.
+     */
+    void InsertAsync(const Language& srclang, const Language& lang, const CatalogItemPtr& item);
+
+    /**
+        Blocks until all items queued by InsertAsync() are written.
+
+        The data aren't committed, call Writer::Commit() for that.
+     */
+    void FlushQueuedInserts();
+
+    /**
+        Prepares the TM for searching in given languages, in the background.
+
+        The first search after launch is much slower than later ones, because
+        the index must be opened and its data loaded. This does that work
+        ahead of time for @a catalog's languages, including running some of
+        its untranslated strings as queries, without blocking the caller.
+        It's only an optimization and never throws.
+     */
+    static void WarmUpAsync(CatalogPtr catalog);
+
+    /// Rules for removing obsolete entries, see Prune()
+    struct RetentionPolicy
+    {
+        /// Remove entries older than this many days (0 to keep all)
+        long maxAgeDays = 0;
+        /// Keep at most this many newest entries per language (0 for no limit)
+        long maxEntriesPerLanguage = 0;
+        /// If set, remove entries whose source text isn't in it
+        std::shared_ptr<const std::unordered_set<std::wstring>> knownSources;
+
+        bool IsEmpty() const { return !maxAgeDays && !maxEntriesPerLanguage && !knownSources; }
+    };
+
+    /// Results of Prune()
+    struct PruneReport
+    {
+        long removedByAge = 0;
+        long removedByLimit = 0;
+        long removedUnused = 0;
+
+        long numDocsBefore = 0, numDocsAfter = 0;
+        long fileSizeBefore = 0, fileSizeAfter = 0;
+        /// Average duration of a search, in milliseconds
+        double searchTimeBefore = 0, searchTimeAfter = 0;
+
+        long GetRemovedCount() const { return removedByAge + removedByLimit + removedUnused; }
+    };
+
+    /**
+        Removes entries as mandated by @a policy and compacts the database.
+
+        This is slow, call it on a background thread. Search time is measured
+        before and after pruning, using a sample of stored entries as queries.
+
+        May throw on error.
+     */
+    PruneReport Prune(const RetentionPolicy& policy);
+
     /// Resets the database to pristine state, removing all data
     void DeleteAllAndReset();
 
@@ -182,8 +284,16 @@ private:
     TranslationMemory();
     ~TranslationMemory();
 
-    TranslationMemoryImpl *m_impl;
+    // Returns the implementation or throws the error that prevented its creation
+    std::shared_ptr<TranslationMemoryImpl> GetImpl();
+    // Same as GetImpl(), but returns nullptr on error
+    std::shared_ptr<TranslationMemoryImpl> TryGetImpl();
+
+    // The implementation may be replaced by DeleteAllAndReset() while it's
+    // used by background threads, who hold a reference to it
+    std::shared_ptr<TranslationMemoryImpl> m_impl;
     std::exception_ptr m_error;
+    std::mutex m_implMutex;
     static TranslationMemory *ms_instance;
 };
 
@@ -26,10 +26,15 @@
 #include "utility.h"
 
 #include <stdio.h>
+#include <algorithm>
+#include <vector>
 
+#include <wx/dir.h>
 #include <wx/filename.h>
 #include <wx/log.h>
 #include <wx/config.h>
+#include <wx/stdpaths.h>
+#include <wx/utils.h>
 
 #if wxUSE_GUI
     #include <wx/display.h>
@@ -92,6 +97,65 @@ wxFileName MakeFileName(const wxString& path)
     return fn;
 }
 
+wxString GetCacheDir(const wxString& category)
+{
+    wxString cache;
+#if defined(__WXOSX__)
+    cache = wxGetHomeDir() + "/Library/Caches/net.poedit.Poedit";
+#elif defined(__UNIX__)
+    if (!wxGetEnv("XDG_CACHE_HOME", &cache))
+        cache = wxGetHomeDir() + "/.cache";
+    cache += "/poedit";
+#else
+    cache = wxStandardPaths::Get().GetUserDataDir() + wxFILE_SEP_PATH + "Cache";
+#endif
+
+    cache += wxFILE_SEP_PATH;
+    cache += category;
+
+    if (!wxFileName::DirExists(cache))
+        wxFileName::Mkdir(cache, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+
+    return cache;
+}
+
+void TrimCacheDir(const wxString& dir, const wxString& wildcard, uint64_t maxSize)
+{
+    wxLogNull null;
+
+    struct CachedFile
+    {
+        wxString name;
+        uint64_t size;
+        time_t mtime;
+    };
+    std::vector<CachedFile> files;
+
+    wxArrayString all;
+    wxDir::GetAllFiles(dir, &all, wildcard, wxDIR_FILES);
+    for (auto& f: all)
+    {
+        wxFileName fn(f);
+        auto mtime = fn.GetModificationTime();
+        auto size = fn.GetSize();
+        if (!mtime.IsValid() || size == wxInvalidSize)
+            continue;
+        files.push_back({f, size.GetValue(), mtime.GetTicks()});
+    }
+
+    // keep most recently used files:
+    std::sort(files.begin(), files.end(),
+              [](const CachedFile& a, const CachedFile& b){ return a.mtime > b.mtime; });
+
+    uint64_t total = 0;
+    for (auto& f: files)
+    {
+        total += f.size;
+        if (total > maxSize)
+            wxRemoveFile(f.name);
+    }
+}
+
 // ----------------------------------------------------------------------
 // TempDirectory
 // ----------------------------------------------------------------------
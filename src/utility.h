@@ -32,6 +32,8 @@
     #endif
 #endif
 
+#include <cstddef>
+#include <cstdint>
 #include <map>
 
 #include <wx/arrstr.h>
@@ -88,6 +90,19 @@ inline bool IsWindows10OrGreater()
 
 wxString EscapeMarkup(const wxString& str);
 
+// FNV-1a hash; unlike std::hash, it's stable across sessions, so it can be
+// used for keys of on-disk caches
+inline uint64_t fnv1a(const void *data, size_t len, uint64_t hash = 14695981039346656037ULL)
+{
+    auto p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < len; i++)
+    {
+        hash ^= p[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
 // Encoding and decoding a string with C escape sequences:
 
 template<typename T>
@@ -191,6 +206,22 @@ inline wxFileName CommonDirectory(const T& a)
 }
 
 
+/**
+    Returns directory for storing cached data of given kind (e.g. "Crowdin")
+    in, creating it if it doesn't exist yet.
+ */
+wxString GetCacheDir(const wxString& category);
+
+/**
+    Limits total size of files matching @a wildcard in cache directory @a dir
+    to @a maxSize bytes, deleting the least recently used ones first.
+
+    Files count as used when they were last modified, so code reading them
+    should update their modification time (see wxFileName::Touch()).
+ */
+void TrimCacheDir(const wxString& dir, const wxString& wildcard, uint64_t maxSize);
+
+
 inline wxString MaskForType(const char *extensions, const wxString& description, bool showExt = true)
 {
     (void)showExt;